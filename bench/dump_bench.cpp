@@ -0,0 +1,67 @@
+#include <chrono>      // std::chrono
+#include <cstdio>      // std::printf
+#include <filesystem>  // std::filesystem
+#include <memory>      // std::shared_ptr
+#include <string>      // std::string
+#include <vector>      // std::vector
+
+#include <dumper.hpp>
+#include <metrics.hpp>
+#include <registry.hpp>
+
+// Measures Dumper::write cost for a fixed number of registered series while
+// varying how many of them are updated between writes.
+
+namespace {
+
+constexpr std::size_t kTotalSeries = 40000;
+constexpr int kIterations = 50;
+
+double measure(Metrics::DumpMode mode, std::size_t active) {
+    const std::string filename = "dump_bench.txt";
+    auto reg = Metrics::createRegistry();
+    auto dumper = std::make_shared<Metrics::Dumper>(filename, mode);
+
+    std::vector<Metrics::Counter> counters;
+    counters.reserve(kTotalSeries);
+    for (std::size_t i = 0; i < kTotalSeries; ++i) {
+        counters.push_back(
+            reg->getMetric<Metrics::Counter>("series_" + std::to_string(i))
+        );
+    }
+    dumper->write(reg);
+
+    std::chrono::nanoseconds spent {0};
+    for (int it = 0; it < kIterations; ++it) {
+        // spread the active series over the whole registry
+        const std::size_t stride = active ? kTotalSeries / active : 0;
+        for (std::size_t i = 0; i < active; ++i) counters[i * stride]++;
+
+        auto const start = std::chrono::steady_clock::now();
+        dumper->write(reg);
+        spent += std::chrono::steady_clock::now() - start;
+    }
+
+    dumper->reset();
+    std::filesystem::remove(filename);
+    return std::chrono::duration<double, std::micro>(spent).count() /
+           kIterations;
+}
+
+}  // namespace
+
+int main() {
+    std::printf(
+        "%zu registered series, %d writes each\n", kTotalSeries, kIterations
+    );
+    std::printf("%10s %14s %14s\n", "active", "full, us", "sparse, us");
+
+    for (std::size_t active : {0, 10, 100, 1000, 10000, 40000}) {
+        std::printf(
+            "%10zu %14.1f %14.1f\n",
+            active,
+            measure(Metrics::DumpMode::Full, active),
+            measure(Metrics::DumpMode::Sparse, active)
+        );
+    }
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#include <chrono>      // std::chrono
+#include <cstdio>      // std::printf
+#include <filesystem>  // std::filesystem
+#include <fstream>     // std::ofstream
+#include <string>      // std::string
+
+#include <file_sink.hpp>
+
+// Compares record throughput of FileSink against the flush-per-record
+// std::ofstream the Dumper used before, with and without fdatasync batching.
+
+namespace {
+
+const std::string kFilename = "sink_bench.txt";
+const std::string kRecord =
+    "2025-06-01 15:00:01.653 \"CPU\" 0.97 \"HTTP RPS\" 42 \"ERRORS\" 3\n";
+
+template <typename WriteFn>
+double recordsPerSecond(int records, WriteFn&& write) {
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < records; ++i) write();
+    const std::chrono::duration<double> spent =
+        std::chrono::steady_clock::now() - start;
+    return records / spent.count();
+}
+
+double ofstreamBaseline(int records) {
+    std::filesystem::remove(kFilename);
+    std::ofstream os(kFilename);
+    return recordsPerSecond(records, [&] {
+        os << kRecord;
+        os.flush();
+    });
+}
+
+double fileSink(int records, Metrics::FileSinkOptions options) {
+    std::filesystem::remove(kFilename);
+    Metrics::FileSink sink(kFilename, options);
+    return recordsPerSecond(records, [&] { sink.write(kRecord); });
+}
+
+}  // namespace
+
+int main() {
+    constexpr int kRecords = 200000;
+    constexpr int kSyncedRecords = 2000;
+
+    Metrics::FileSinkOptions batched;
+    batched.sync_every = 64;
+    Metrics::FileSinkOptions every;
+    every.sync_every = 1;
+
+    std::printf("%-28s %14s\n", "sink", "records/s");
+    std::printf(
+        "%-28s %14.0f\n", "ofstream + flush", ofstreamBaseline(kRecords)
+    );
+    std::printf("%-28s %14.0f\n", "FileSink, no sync", fileSink(kRecords, {}));
+    std::printf(
+        "%-28s %14.0f\n",
+        "FileSink, sync every 64",
+        fileSink(kSyncedRecords * 8, batched)
+    );
+    std::printf(
+        "%-28s %14.0f\n",
+        "FileSink, sync every record",
+        fileSink(kSyncedRecords, every)
+    );
+
+    std::filesystem::remove(kFilename);
+}
\ No newline at end of file
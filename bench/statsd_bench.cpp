@@ -0,0 +1,96 @@
+#include <chrono>  // std::chrono
+#include <cstdio>  // std::printf
+#include <memory>  // std::make_shared
+#include <string>  // std::string, std::to_string
+
+#ifndef _WIN32
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <metrics.hpp>
+#include <registry.hpp>
+#include <statsd_exporter.hpp>
+
+// Measures how fast StatsdExporter pushes a registry to a local UDP port,
+// for several batch sizes. Nothing reads the port, so the numbers are the
+// sender's cost alone.
+
+namespace {
+
+#ifndef _WIN32
+// Bound but never read; the kernel drops what overflows its buffer.
+class Sink {
+private:
+    int m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    uint16_t m_port = 0;
+public:
+    Sink() {
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+        socklen_t len = sizeof(addr);
+        getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+    }
+
+    ~Sink() { close(m_fd); }
+
+    uint16_t port() const { return m_port; }
+};
+#endif
+
+void run(
+    const std::shared_ptr<Metrics::Registry>& reg,
+    uint16_t port,
+    std::size_t batch,
+    int writes
+) {
+    Metrics::StatsdOptions options;
+    options.batch = batch;
+    options.mode = Metrics::DumpMode::Full;
+    auto exporter =
+        std::make_shared<Metrics::StatsdExporter>("127.0.0.1", port, options);
+
+    auto const start = std::chrono::steady_clock::now();
+    for (int i = 0; i < writes; ++i) exporter->write(reg);
+    const std::chrono::duration<double> spent =
+        std::chrono::steady_clock::now() - start;
+
+    std::printf(
+        "%8zu %16.0f %16.0f %10llu\n",
+        batch,
+        exporter->packetsSent() / spent.count(),
+        exporter->metricsSent() / spent.count(),
+        static_cast<unsigned long long>(exporter->dropped())
+    );
+}
+
+}  // namespace
+
+int main() {
+#ifdef _WIN32
+    std::printf("statsd_bench is not supported on Windows\n");
+#else
+    constexpr int kSeries = 20000;
+    constexpr int kWrites = 50;
+
+    auto reg = Metrics::createRegistry();
+    for (int i = 0; i < kSeries; ++i) {
+        reg->getMetric<Metrics::Gauge>(
+            "service.endpoint_" + std::to_string(i) + ".latency"
+        ) += i;
+    }
+
+    Sink sink;
+    std::printf(
+        "%8s %16s %16s %10s\n", "batch", "packets/s", "metrics/s", "dropped"
+    );
+    for (std::size_t batch : {1, 8, 32, 64}) {
+        run(reg, sink.port(), batch, kWrites);
+    }
+#endif
+}
\ No newline at end of file
@@ -5,4 +5,5 @@ class MetricsCPP(ConanFile):
     generators = "CMakeDeps", "CMakeToolchain"
 
     def requirements(self):
-        self.requires("catch2/3.10.0")
\ No newline at end of file
+        self.requires("catch2/3.10.0")
+        self.requires("zlib/1.3.1")
\ No newline at end of file
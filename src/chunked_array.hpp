@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>    // std::array
+#include <atomic>   // std::atomic
+#include <cstddef>  // std::size_t
+
+namespace Metrics {
+
+// Array that grows in fixed-size chunks which never move. Chunks are
+// installed with a CAS, so growing needs no lock and element references stay
+// valid for the lifetime of the array.
+template <typename T, std::size_t ChunkSize, std::size_t MaxChunks>
+class ChunkedArray {
+private:
+    std::array<std::atomic<T*>, MaxChunks> m_chunks {};
+public:
+    static constexpr std::size_t kCapacity = ChunkSize * MaxChunks;
+
+    ChunkedArray() = default;
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+    ~ChunkedArray() {
+        for (auto& chunk : m_chunks) delete[] chunk.load();
+    }
+
+    // Makes elements [0, size) addressable. Returns false past kCapacity.
+    bool reserve(std::size_t size) {
+        if (size > kCapacity) return false;
+        for (std::size_t c = 0; c * ChunkSize < size; ++c) {
+            if (m_chunks[c].load(std::memory_order_acquire)) continue;
+
+            T* fresh = new T[ChunkSize]();
+            T* expected = nullptr;
+            if (!m_chunks[c].compare_exchange_strong(
+                    expected, fresh, std::memory_order_acq_rel
+                )) {
+                delete[] fresh;
+            }
+        }
+        return true;
+    }
+
+    // Element `i`, or nullptr if its chunk has not been reserved yet.
+    T* at(std::size_t i) const {
+        if (i >= kCapacity) return nullptr;
+        T* chunk = m_chunks[i / ChunkSize].load(std::memory_order_acquire);
+        return chunk ? chunk + i % ChunkSize : nullptr;
+    }
+
+    T& operator[](std::size_t i) const {
+        return m_chunks[i / ChunkSize].load(
+            std::memory_order_acquire
+        )[i % ChunkSize];
+    }
+};
+
+}  // namespace Metrics
\ No newline at end of file
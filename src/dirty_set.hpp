@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>  // std::atomic
+#include <chunked_array.hpp>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint64_t
+#include <memory>   // std::shared_ptr
+
+namespace Metrics {
+
+// Bitmap of "changed since last collection" flags, one bit per registry slot.
+// Words live in chunks that never move, so the set grows without a lock and
+// setting or taking bits is lock-free.
+class DirtySet {
+public:
+    static constexpr std::size_t kBitsPerWord = 64;
+    static constexpr std::size_t kWordsPerChunk = 64;
+    static constexpr std::size_t kSlotsPerChunk = kBitsPerWord * kWordsPerChunk;
+    static constexpr std::size_t kMaxChunks = 1024;
+private:
+    ChunkedArray<std::atomic<uint64_t>, kWordsPerChunk, kMaxChunks> m_words;
+public:
+    static constexpr std::size_t kCapacity = kSlotsPerChunk * kMaxChunks;
+
+    bool reserve(std::size_t slots) { return m_words.reserve(wordsFor(slots)); }
+
+    std::atomic<uint64_t>& word(std::size_t slot) {
+        return m_words[slot / kBitsPerWord];
+    }
+
+    void set(std::size_t slot) {
+        word(slot).fetch_or(mask(slot), std::memory_order_release);
+    }
+
+    void clear(std::size_t slot) {
+        word(slot).fetch_and(~mask(slot), std::memory_order_release);
+    }
+
+    // Sets the bit unless it is already set, so repeated updates between
+    // collections only read the shared word. The check races with take():
+    // metrics update their value and read this bit with seq_cst, as take()
+    // clears the bit and collectors read the value, so an update that sees
+    // the bit still set is seen by the collection that clears it.
+    void mark(std::size_t slot) {
+        auto& w = word(slot);
+        if (!(w.load(std::memory_order_seq_cst) & mask(slot))) {
+            w.fetch_or(mask(slot), std::memory_order_release);
+        }
+    }
+
+    // Returns the bits of word `w` and clears them.
+    uint64_t take(std::size_t w) {
+        auto* word = m_words.at(w);
+        return word ? word->exchange(0, std::memory_order_seq_cst) : 0;
+    }
+
+    // Sets the bits of word `w` present in `bits`, if the word is reserved.
+    void merge(std::size_t w, uint64_t bits) {
+        auto* word = m_words.at(w);
+        if (word) word->fetch_or(bits, std::memory_order_release);
+    }
+
+    uint64_t peek(std::size_t w) const {
+        auto* word = m_words.at(w);
+        return word ? word->load(std::memory_order_acquire) : 0;
+    }
+
+    static uint64_t mask(std::size_t slot) {
+        return uint64_t {1} << (slot % kBitsPerWord);
+    }
+
+    static std::size_t wordsFor(std::size_t slots) {
+        return (slots + kBitsPerWord - 1) / kBitsPerWord;
+    }
+};
+
+// forward declaration
+class Registry;
+
+// One consumer's position in a registry's change stream. The registry keeps
+// a bitmap per cursor, so sinks reading the same registry each see every
+// change. A cursor binds to the registry it is first collected from; moving
+// it to another registry starts over, and that first collection must not
+// overlap another one through the same cursor.
+class DirtyCursor {
+private:
+    friend class Registry;
+
+    struct State {
+        DirtySet pending;
+        std::atomic<bool> in_use {true};
+        // nothing collected yet, so every metric counts as changed
+        std::atomic<bool> fresh {true};
+    };
+
+    std::shared_ptr<State> m_state;
+    uint64_t m_registry = 0;
+
+    void release() {
+        if (m_state) m_state->in_use.store(false, std::memory_order_release);
+    }
+public:
+    DirtyCursor() = default;
+    ~DirtyCursor() { release(); }
+
+    DirtyCursor(const DirtyCursor&) = delete;
+    DirtyCursor& operator=(const DirtyCursor&) = delete;
+};
+
+}  // namespace Metrics
\ No newline at end of file
@@ -2,24 +2,45 @@
 #include <dumper.hpp>
 #include <format>  // std::format
 #include <registry.hpp>
+#include <self_stats.hpp>
 #include <visitors.hpp>
 
 namespace Metrics {
 
 void Dumper::write(std::shared_ptr<Metrics::Registry> registry) {
-    m_os << getCurrentTimestamp();
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::chrono::steady_clock::time_point start;
+    if constexpr (SelfStats::kEnabled) start = std::chrono::steady_clock::now();
+
+    std::string record = getCurrentTimestamp();
 
     StringValueVisitor sv_visitor;
-    ResetVisitor reset_visitor;
+    CounterResetVisitor reset_visitor;
 
-    for (const auto& [metric_name, metric_value] : registry->getMetricGroup()) {
-        sv_visitor.setMetricName(metric_name);
-        metric_value->accept(sv_visitor);
-        metric_value->accept(reset_visitor);
-    }
+    // Counters untouched since the last write were already reset by it.
+    // Gauges keep their level.
+    registry->collect(
+        m_cursor,
+        [&](const std::string& metric_name,
+            const std::shared_ptr<IMetrics>& metric_value,
+            bool changed) {
+            sv_visitor.setMetricName(metric_name);
+            metric_value->accept(sv_visitor);
+            if (changed) metric_value->accept(reset_visitor);
+        },
+        m_mode == DumpMode::Full
+    );
 
-    m_os << sv_visitor.getResult() << '\n';
-    m_os.flush();
+    record += sv_visitor.getResult();
+    record += '\n';
+    m_sink.write(record);
+
+    if constexpr (SelfStats::kEnabled) {
+        SelfStats::dumped(
+            std::chrono::steady_clock::now() - start, record.size()
+        );
+    }
 }
 
 void Dumper::enableAutoWrite(
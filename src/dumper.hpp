@@ -1,8 +1,10 @@
 #pragma once
 
-#include <chrono>       // std::chrono::seconds
-#include <fstream>      // std::ofstream
+#include <chrono>  // std::chrono::seconds
+#include <dirty_set.hpp>
+#include <file_sink.hpp>
 #include <memory>       // std::shared_ptr
+#include <mutex>        // std::mutex
 #include <string>       // std::string
 #include <string_view>  // std::string_view
 #include <thread>       // std::jthread
@@ -12,19 +14,30 @@ namespace Metrics {
 // forward declaration
 class Registry;
 
+// Full writes every registered metric on each line; Sparse writes only the
+// metrics updated since the previous write.
+enum class DumpMode { Full, Sparse };
+
 class Dumper : public std::enable_shared_from_this<Dumper> {
 private:
-    std::ofstream m_os;
+    FileSink m_sink;
     const std::string m_filename;
+    const DumpMode m_mode;
+    // which metrics changed since this dumper's previous write
+    DirtyCursor m_cursor;
+    std::mutex m_mutex;
     std::jthread m_worker;
 public:
-    Dumper(std::string_view filename) : m_filename(filename) {
-        m_os.open(std::string(filename));
-    }
+    Dumper(
+        std::string_view filename,
+        DumpMode mode = DumpMode::Full,
+        FileSinkOptions options = {}
+    )
+        : m_sink(filename, options), m_filename(filename), m_mode(mode) {}
 
     ~Dumper() {
         disableAutoWrite();
-        if (m_os.is_open()) m_os.close();
+        m_sink.close();
     }
 
     void write(std::shared_ptr<Metrics::Registry> registry);
@@ -35,7 +48,7 @@ public:
     void disableAutoWrite();
     void reset() {
         disableAutoWrite();
-        if (m_os.is_open()) m_os.close();
+        m_sink.close();
     }
 };
 
@@ -0,0 +1,148 @@
+#include <atomic>   // std::atomic
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint64_t
+#include <epoch.hpp>
+#include <limits>  // std::numeric_limits
+
+namespace Metrics {
+
+namespace {
+
+constexpr uint64_t kIdle = std::numeric_limits<uint64_t>::max();
+constexpr std::size_t kReclaimEvery = 64;
+
+// One per thread that ever pinned; records are reused after thread exit.
+struct Record {
+    std::atomic<uint64_t> epoch {kIdle};
+    std::atomic<bool> in_use {true};
+    Record* next = nullptr;
+};
+
+struct Retired {
+    void* ptr;
+    void (*deleter)(void*);
+    uint64_t epoch;
+    Retired* next;
+};
+
+std::atomic<uint64_t> g_epoch {0};
+std::atomic<Record*> g_records {nullptr};
+std::atomic<Retired*> g_retired {nullptr};
+std::atomic<std::size_t> g_retire_count {0};
+
+Record* acquireRecord() {
+    for (Record* r = g_records.load(std::memory_order_acquire); r;
+         r = r->next) {
+        bool free = false;
+        if (!r->in_use.load(std::memory_order_relaxed) &&
+            r->in_use.compare_exchange_strong(
+                free, true, std::memory_order_acq_rel
+            )) {
+            return r;
+        }
+    }
+
+    Record* r = new Record;
+    r->next = g_records.load(std::memory_order_relaxed);
+    while (!g_records.compare_exchange_weak(
+        r->next, r, std::memory_order_release, std::memory_order_relaxed
+    )) {
+    }
+    return r;
+}
+
+struct ThreadState {
+    Record* record = acquireRecord();
+    unsigned nesting = 0;
+
+    ~ThreadState() {
+        record->epoch.store(kIdle, std::memory_order_release);
+        record->in_use.store(false, std::memory_order_release);
+    }
+};
+
+thread_local ThreadState t_state;
+
+void pushRetired(Retired* first, Retired* last) {
+    last->next = g_retired.load(std::memory_order_relaxed);
+    while (!g_retired.compare_exchange_weak(
+        last->next, first, std::memory_order_release, std::memory_order_relaxed
+    )) {
+    }
+}
+
+// Moves the global epoch forward if every pinned thread has observed it.
+void tryAdvance() {
+    uint64_t current = g_epoch.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (Record* r = g_records.load(std::memory_order_acquire); r;
+         r = r->next) {
+        const uint64_t pinned = r->epoch.load(std::memory_order_acquire);
+        if (pinned != kIdle && pinned != current) return;
+    }
+    g_epoch.compare_exchange_strong(
+        current, current + 1, std::memory_order_acq_rel
+    );
+}
+
+}  // namespace
+
+Epoch::Guard::Guard() {
+    ThreadState& state = t_state;
+    if (state.nesting++ == 0) {
+        state.record->epoch.store(
+            g_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed
+        );
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+Epoch::Guard::~Guard() {
+    ThreadState& state = t_state;
+    if (--state.nesting == 0) {
+        state.record->epoch.store(kIdle, std::memory_order_release);
+    }
+}
+
+void Epoch::retire(void* ptr, void (*deleter)(void*)) {
+    auto* node = new Retired {
+        ptr, deleter, g_epoch.load(std::memory_order_acquire), nullptr
+    };
+    pushRetired(node, node);
+
+    if (g_retire_count.fetch_add(1, std::memory_order_relaxed) %
+            kReclaimEvery ==
+        kReclaimEvery - 1) {
+        reclaim();
+    }
+}
+
+void Epoch::reclaim() {
+    tryAdvance();
+
+    // objects retired in epoch e may still be seen by readers pinned in e
+    // or e + 1
+    const uint64_t current = g_epoch.load(std::memory_order_acquire);
+    Retired* list = g_retired.exchange(nullptr, std::memory_order_acq_rel);
+
+    Retired* keep_first = nullptr;
+    Retired* keep_last = nullptr;
+    while (list) {
+        Retired* node = list;
+        list = list->next;
+
+        if (node->epoch + 2 <= current) {
+            node->deleter(node->ptr);
+            delete node;
+        } else {
+            node->next = keep_first;
+            keep_first = node;
+            if (!keep_last) keep_last = node;
+        }
+    }
+
+    if (keep_first) pushRetired(keep_first, keep_last);
+}
+
+}  // namespace Metrics
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+namespace Metrics {
+
+// Epoch-based reclamation shared by all registries. Readers pin the current
+// epoch with a Guard while they hold pointers into lock-free structures;
+// writers hand unlinked objects to retire() and they are freed once every
+// thread pinned at the time of removal has left its critical section.
+class Epoch {
+public:
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    };
+
+    static void retire(void* ptr, void (*deleter)(void*));
+
+    template <typename T>
+    static void retire(T* ptr) {
+        retire(static_cast<void*>(ptr), [](void* p) {
+            delete static_cast<T*>(p);
+        });
+    }
+
+    // Tries to advance the epoch and frees what is safe to free. Called
+    // periodically by retire(); it cannot get past an epoch the calling
+    // thread itself has pinned.
+    static void reclaim();
+};
+
+}  // namespace Metrics
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include <algorithm>  // std::min, std::sort
+#include <charconv>   // std::from_chars
+#include <file_sink.hpp>
+#include <fstream>   // std::ifstream
+#include <iterator>  // std::prev
+#include <vector>    // std::vector
+
+#ifdef _WIN32
+#include <fcntl.h>     // _O_*
+#include <io.h>        // _wsopen_s, _write, _commit, _close
+#include <share.h>     // _SH_DENYNO
+#include <sys/stat.h>  // _S_IREAD, _S_IWRITE
+#else
+#include <fcntl.h>   // open
+#include <unistd.h>  // write, fdatasync, fsync, close
+#include <cerrno>    // errno, EINTR
+#endif
+
+#ifdef METRICS_CPP_WITH_ZLIB
+#include <zlib.h>  // gzopen, gzwrite, gzclose
+#endif
+
+namespace fs = std::filesystem;
+
+namespace Metrics {
+
+namespace {
+
+#ifdef _WIN32
+int openAppend(const fs::path& path) {
+    int fd = -1;
+    _wsopen_s(
+        &fd,
+        path.c_str(),
+        _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY | _O_NOINHERIT,
+        _SH_DENYNO,
+        _S_IREAD | _S_IWRITE
+    );
+    return fd;
+}
+
+bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const int n =
+            _write(fd, data.data(), static_cast<unsigned>(data.size()));
+        if (n <= 0) return false;
+        data.remove_prefix(static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+void syncData(int fd) { _commit(fd); }
+void closeFd(int fd) { _close(fd); }
+#else
+int openAppend(const fs::path& path) {
+    return ::open(
+        path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644
+    );
+}
+
+bool writeAll(int fd, std::string_view data) {
+    while (!data.empty()) {
+        const ssize_t n = ::write(fd, data.data(), data.size());
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data.remove_prefix(static_cast<std::size_t>(n));
+    }
+    return true;
+}
+
+void syncData(int fd) {
+#ifdef __APPLE__
+    ::fsync(fd);
+#else
+    ::fdatasync(fd);
+#endif
+}
+
+void closeFd(int fd) { ::close(fd); }
+#endif
+
+// Cuts everything after the last '\n' and returns the resulting size.
+std::uintmax_t dropPartialRecord(const fs::path& path) {
+    std::error_code ec;
+    const std::uintmax_t size = fs::file_size(path, ec);
+    if (ec || size == 0) return 0;
+
+    std::uintmax_t keep = 0;
+    {
+        std::ifstream in(path, std::ios::binary);
+        char buf[4096];
+        for (std::uintmax_t end = size; end > 0 && keep == 0;) {
+            const auto len = std::min<std::uintmax_t>(end, sizeof(buf));
+            in.seekg(static_cast<std::streamoff>(end - len));
+            in.read(buf, static_cast<std::streamsize>(len));
+            for (std::uintmax_t i = len; i > 0; --i) {
+                if (buf[i - 1] == '\n') {
+                    keep = end - len + i;
+                    break;
+                }
+            }
+            end -= len;
+        }
+    }
+
+    if (keep != size) fs::resize_file(path, keep, ec);
+    return keep;
+}
+
+struct Rotated {
+    std::uint64_t index;
+    fs::path path;
+    bool compressed;
+};
+
+// Rotated siblings of `path`, oldest first.
+std::vector<Rotated> listRotated(const fs::path& path) {
+    std::vector<Rotated> result;
+    const fs::path dir =
+        path.has_parent_path() ? path.parent_path() : fs::path(".");
+    const std::string prefix = path.filename().string() + '.';
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (!name.starts_with(prefix)) continue;
+
+        std::string_view rest = std::string_view(name).substr(prefix.size());
+        const bool compressed = rest.ends_with(".gz");
+        if (compressed) rest.remove_suffix(3);
+
+        std::uint64_t index = 0;
+        auto [ptr, err] =
+            std::from_chars(rest.data(), rest.data() + rest.size(), index);
+        if (err != std::errc() || ptr != rest.data() + rest.size()) continue;
+
+        result.push_back({index, entry.path(), compressed});
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.index < b.index;
+    });
+    return result;
+}
+
+void gzipFile(const fs::path& src) {
+#ifdef METRICS_CPP_WITH_ZLIB
+    std::ifstream in(src, std::ios::binary);
+    if (!in) return;
+
+    const fs::path dst = src.string() + ".gz";
+    const fs::path tmp = dst.string() + ".tmp";
+    gzFile out = gzopen(tmp.string().c_str(), "wb");
+    if (!out) return;
+
+    bool ok = true;
+    char buf[1 << 16];
+    while (ok && (in.read(buf, sizeof(buf)) || in.gcount() > 0)) {
+        const auto len = static_cast<unsigned>(in.gcount());
+        ok = gzwrite(out, buf, len) == static_cast<int>(len);
+    }
+    ok = gzclose(out) == Z_OK && ok;
+    in.close();
+
+    std::error_code ec;
+    if (ok) {
+        fs::rename(tmp, dst, ec);
+        if (!ec) fs::remove(src, ec);
+    } else {
+        fs::remove(tmp, ec);
+    }
+#else
+    (void)src;
+#endif
+}
+
+}  // namespace
+
+FileSink::FileSink(std::string_view path, FileSinkOptions options)
+    : m_path(path), m_options(options) {
+    std::vector<Rotated> rotated = listRotated(m_path);
+    if (!rotated.empty()) m_next_index = rotated.back().index + 1;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_size = dropPartialRecord(m_path);
+    openLocked();
+
+#ifdef METRICS_CPP_WITH_ZLIB
+    if (m_options.compress) {
+        // pick up files rotated before a crash but never compressed
+        for (auto& file : rotated) {
+            if (!file.compressed) m_queue.push_back(std::move(file.path));
+        }
+        m_compressor = std::jthread([this](std::stop_token st) {
+            compressLoop(st);
+        });
+    }
+#endif
+
+    if (m_options.max_age.count() > 0 || m_options.sync_interval.count() > 0) {
+        m_timer = std::jthread([this](std::stop_token st) { timerLoop(st); });
+    }
+}
+
+FileSink::~FileSink() { close(); }
+
+bool FileSink::openLocked() {
+    m_fd = openAppend(m_path);
+    m_unsynced = 0;
+    m_opened = m_synced = std::chrono::steady_clock::now();
+    return m_fd >= 0;
+}
+
+bool FileSink::is_open() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_fd >= 0;
+}
+
+bool FileSink::write(std::string_view record) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) return false;
+
+    const bool timed = m_options.max_age.count() > 0 ||
+                       m_options.sync_interval.count() > 0;
+    const auto now = timed ? std::chrono::steady_clock::now() : m_opened;
+
+    if (m_size > 0 &&
+        ((m_options.max_bytes > 0 &&
+          m_size + record.size() > m_options.max_bytes) ||
+         (m_options.max_age.count() > 0 &&
+          now - m_opened >= m_options.max_age))) {
+        rotateLocked();
+        if (m_fd < 0) return false;
+    }
+
+    if (!writeAll(m_fd, record)) {
+        // never leave a torn record in front of the next one
+        std::error_code ec;
+        fs::resize_file(m_path, m_size, ec);
+        return false;
+    }
+    m_size += record.size();
+    ++m_unsynced;
+
+    if ((m_options.sync_every > 0 && m_unsynced >= m_options.sync_every) ||
+        (m_options.sync_interval.count() > 0 &&
+         now - m_synced >= m_options.sync_interval)) {
+        syncLocked();
+    }
+    return true;
+}
+
+void FileSink::sync() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    syncLocked();
+}
+
+void FileSink::syncLocked() {
+    if (m_fd < 0 || m_unsynced == 0) return;
+    syncData(m_fd);
+    m_unsynced = 0;
+    if (m_options.sync_interval.count() > 0) {
+        m_synced = std::chrono::steady_clock::now();
+    }
+}
+
+void FileSink::close() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_fd < 0) return;
+    if (m_options.sync_every > 0 || m_options.sync_interval.count() > 0) {
+        syncLocked();
+    }
+    closeFd(m_fd);
+    m_fd = -1;
+}
+
+void FileSink::rotateLocked() {
+    if (m_options.sync_every > 0 || m_options.sync_interval.count() > 0) {
+        syncLocked();
+    }
+    closeFd(m_fd);
+    m_fd = -1;
+
+    fs::path rotated = m_path.string() + '.' + std::to_string(m_next_index++);
+    std::error_code ec;
+    fs::rename(m_path, rotated, ec);
+    openLocked();
+
+    if (ec) {
+        // the records are still there; the next write tries again
+        std::error_code size_ec;
+        m_size = fs::file_size(m_path, size_ec);
+        if (size_ec) m_size = 0;
+        return;
+    }
+    m_size = 0;
+    pruneLocked();
+
+    if (m_compressor.joinable()) {
+        {
+            std::lock_guard<std::mutex> queue_lock(m_queue_mutex);
+            m_queue.push_back(std::move(rotated));
+        }
+        m_queue_cv.notify_one();
+    }
+}
+
+void FileSink::pruneLocked() {
+    if (m_options.max_files == 0) return;
+
+    std::vector<Rotated> rotated = listRotated(m_path);
+    std::size_t kept = 0;
+    std::error_code ec;
+    // walk newest first, a file may briefly exist both plain and gzipped
+    for (auto it = rotated.rbegin(); it != rotated.rend(); ++it) {
+        const bool same_as_newer =
+            it != rotated.rbegin() && std::prev(it)->index == it->index;
+        if (!same_as_newer) ++kept;
+        if (kept > m_options.max_files) fs::remove(it->path, ec);
+    }
+}
+
+void FileSink::compressLoop(std::stop_token st) {
+    while (!st.stop_requested()) {
+        fs::path next;
+        {
+            std::unique_lock<std::mutex> lock(m_queue_mutex);
+            if (!m_queue_cv.wait(lock, st, [this] {
+                    return !m_queue.empty();
+                })) {
+                return;
+            }
+            next = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+        gzipFile(next);
+    }
+}
+
+void FileSink::timerLoop(std::stop_token st) {
+    using std::chrono::milliseconds;
+    milliseconds period = m_options.sync_interval;
+    if (m_options.max_age.count() > 0) {
+        const milliseconds age = m_options.max_age;
+        period = period.count() > 0 ? std::min(period, age) : age;
+    }
+
+    std::mutex sleep_mutex;
+    std::condition_variable_any sleep_cv;
+    std::unique_lock<std::mutex> sleep_lock(sleep_mutex);
+    for (;;) {
+        sleep_cv.wait_for(sleep_lock, st, period, [] { return false; });
+        if (st.stop_requested()) return;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_fd < 0) continue;
+
+        const auto now = std::chrono::steady_clock::now();
+        if (m_size > 0 && m_options.max_age.count() > 0 &&
+            now - m_opened >= m_options.max_age) {
+            rotateLocked();  // syncs the old file first
+        } else if (m_options.sync_interval.count() > 0 &&
+                   now - m_synced >= m_options.sync_interval) {
+            syncLocked();
+        }
+    }
+}
+
+}  // namespace Metrics
\ No newline at end of file
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>              // std::chrono
+#include <condition_variable>  // std::condition_variable_any
+#include <cstddef>             // std::size_t
+#include <cstdint>             // std::uintmax_t
+#include <deque>               // std::deque
+#include <filesystem>          // std::filesystem::path
+#include <mutex>               // std::mutex
+#include <string>              // std::string
+#include <string_view>         // std::string_view
+#include <thread>              // std::jthread
+
+namespace Metrics {
+
+struct FileSinkOptions {
+    // Rotate before a record would grow the file past this size; 0 disables.
+    std::uintmax_t max_bytes = 0;
+    // Rotate once the file has been open for this long, checked on each
+    // write and by a background timer; 0 disables.
+    std::chrono::seconds max_age {0};
+    // Number of rotated files to keep, oldest are removed; 0 keeps all.
+    std::size_t max_files = 0;
+    // Gzip rotated files on a background thread (needs zlib).
+    bool compress = false;
+    // fdatasync after this many records; 0 leaves flushing to the OS.
+    std::size_t sync_every = 0;
+    // Also fdatasync pending records once this much time has passed since
+    // the previous sync, checked on each write and by a background timer, so
+    // the last records get synced even if no write follows; 0 disables.
+    std::chrono::milliseconds sync_interval {0};
+};
+
+// Append-only record file. Every record is a single O_APPEND write, so a
+// crash can only leave a torn tail, which is cut off when the file is opened
+// again. Rotated files are named "<path>.<N>[.gz]" with N growing over time.
+class FileSink {
+private:
+    const std::filesystem::path m_path;
+    const FileSinkOptions m_options;
+
+    std::mutex m_mutex;
+    int m_fd = -1;
+    std::uintmax_t m_size = 0;
+    std::uint64_t m_next_index = 1;
+    std::size_t m_unsynced = 0;
+    std::chrono::steady_clock::time_point m_opened;
+    std::chrono::steady_clock::time_point m_synced;
+
+    std::mutex m_queue_mutex;
+    std::condition_variable_any m_queue_cv;
+    std::deque<std::filesystem::path> m_queue;
+    std::jthread m_compressor;
+    // drives max_age and sync_interval between writes
+    std::jthread m_timer;
+
+    bool openLocked();
+    void syncLocked();
+    void rotateLocked();
+    void pruneLocked();
+    void compressLoop(std::stop_token st);
+    void timerLoop(std::stop_token st);
+public:
+    FileSink(std::string_view path, FileSinkOptions options = {});
+    ~FileSink();
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    bool is_open();
+    // `record` must be a whole record including its trailing '\n'.
+    bool write(std::string_view record);
+    void sync();
+    void close();
+
+    const std::filesystem::path& path() const { return m_path; }
+};
+
+}  // namespace Metrics
\ No newline at end of file
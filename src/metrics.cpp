@@ -1,5 +1,8 @@
-#include <atomic>  // std::atomic
+#include <algorithm>  // std::max
+#include <atomic>     // std::atomic
+#include <dirty_set.hpp>
 #include <metrics.hpp>
+#include <self_stats.hpp>
 
 namespace Metrics {
 
@@ -11,33 +14,110 @@ void IGauge::accept(IMetricsVisitor& visitor) {
     visitor.visit(shared_from_this());
 }
 
+// Per-metric link to a DirtySet slot. The first set a metric is bound to
+// owns it for good; the slot may change as the metric is removed and
+// registered again. Only the first update after a collection pays for the
+// read-modify-write on the shared word.
+class DirtyMark {
+private:
+    static constexpr std::size_t kNoSlot = static_cast<std::size_t>(-1);
+    enum State : int { kUnbound, kBinding, kBound };
+
+    std::atomic<int> m_state {kUnbound};
+    std::shared_ptr<DirtySet> m_owner;
+    std::atomic<std::size_t> m_slot {kNoSlot};
+public:
+    bool bind(std::shared_ptr<DirtySet> set, std::size_t slot) {
+        int state = kUnbound;
+        if (m_state.compare_exchange_strong(
+                state, kBinding, std::memory_order_acq_rel
+            )) {
+            m_owner = std::move(set);
+            m_slot.store(slot, std::memory_order_release);
+            m_state.store(kBound, std::memory_order_release);
+            return true;
+        }
+        if (state != kBound || m_owner != set) return false;
+
+        std::size_t current = kNoSlot;
+        return m_slot.compare_exchange_strong(
+                   current, slot, std::memory_order_acq_rel
+               ) ||
+               current == slot;
+    }
+
+    void unbind(const DirtySet* set, std::size_t slot) {
+        if (m_state.load(std::memory_order_acquire) != kBound ||
+            m_owner.get() != set) {
+            return;
+        }
+        m_slot.compare_exchange_strong(
+            slot, kNoSlot, std::memory_order_acq_rel
+        );
+    }
+
+    void mark() noexcept {
+        const std::size_t slot = m_slot.load(std::memory_order_acquire);
+        if (slot != kNoSlot) m_owner->mark(slot);
+    }
+};
+
+// Counts only ever grow; reset() moves the base value() is measured from,
+// which keeps total() intact for consumers that share the counter.
 class CounterImpl : public ICounter {
 private:
     std::atomic<uint64_t> m_value;
+    std::atomic<uint64_t> m_base {0};
+    DirtyMark m_dirty;
 public:
     CounterImpl() noexcept { m_value.store(0); }
     CounterImpl(uint64_t value) noexcept { m_value.store(value); }
     CounterImpl(const CounterImpl&) = delete;
     CounterImpl(CounterImpl&&) = delete;
 
+    // The base is read first: it was taken from an earlier total, so the
+    // difference cannot wrap.
     uint64_t value() const override {
-        return m_value.load(std::memory_order_acquire);
+        const uint64_t base = m_base.load(std::memory_order_seq_cst);
+        return total() - base;
+    }
+    // seq_cst pairs with DirtySet::mark and DirtySet::take
+    uint64_t total() const override {
+        return m_value.load(std::memory_order_seq_cst);
+    }
+    void reset() override {
+        const uint64_t current = total();
+        uint64_t base = m_base.load(std::memory_order_relaxed);
+        while (base < current &&
+               !m_base.compare_exchange_weak(
+                   base, current, std::memory_order_seq_cst
+               )) {
+        }
     }
-    void reset() override { m_value.store(0, std::memory_order_release); }
 
     ICounter& operator++(int) override {
-        m_value.fetch_add(1, std::memory_order_acq_rel);
+        m_value.fetch_add(1, std::memory_order_seq_cst);
+        m_dirty.mark();
         return *this;
     }
     ICounter& operator+=(uint64_t value) override {
-        m_value.fetch_add(value, std::memory_order_acq_rel);
+        m_value.fetch_add(value, std::memory_order_seq_cst);
+        m_dirty.mark();
         return *this;
     }
+
+    bool track(std::shared_ptr<DirtySet> set, std::size_t slot) override {
+        return m_dirty.bind(std::move(set), slot);
+    }
+    void untrack(const DirtySet* set, std::size_t slot) override {
+        m_dirty.unbind(set, slot);
+    }
 };
 
 class GaugeImpl : public IGauge {
 private:
     std::atomic<double> m_value;
+    DirtyMark m_dirty;
 public:
     GaugeImpl() noexcept { m_value.store(0.0); }
     GaugeImpl(double value) noexcept { m_value.store(value); }
@@ -45,28 +125,44 @@ public:
     GaugeImpl(GaugeImpl&&) = delete;
 
     double value() const override {
-        return m_value.load(std::memory_order_acquire);
+        return m_value.load(std::memory_order_seq_cst);
     }
     void reset() override { m_value.store(0.0, std::memory_order_release); }
 
     IGauge& operator+=(double value) override {
         double expected = m_value.load(std::memory_order_acquire);
         while (!m_value.compare_exchange_weak(
-            expected, expected + value, std::memory_order_acq_rel
+            expected, expected + value, std::memory_order_seq_cst
         )) {
         }
+        m_dirty.mark();
         return *this;
     }
     IGauge& operator-=(double value) override {
         double expected = m_value.load(std::memory_order_acquire);
         while (!m_value.compare_exchange_weak(
-            expected, expected - value, std::memory_order_acq_rel
+            expected, expected - value, std::memory_order_seq_cst
         )) {
         }
+        m_dirty.mark();
         return *this;
     }
+
+    bool track(std::shared_ptr<DirtySet> set, std::size_t slot) override {
+        return m_dirty.bind(std::move(set), slot);
+    }
+    void untrack(const DirtySet* set, std::size_t slot) override {
+        m_dirty.unbind(set, slot);
+    }
 };
 
+#ifdef METRICS_CPP_SELF_STATS
+std::size_t SelfStats::metricBytes() {
+    // make_shared keeps the two reference counts next to the object
+    return std::max(sizeof(CounterImpl), sizeof(GaugeImpl)) + 2 * sizeof(long);
+}
+#endif
+
 std::shared_ptr<ICounter> createCounter() {
     return std::make_shared<CounterImpl>();
 }
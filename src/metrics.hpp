@@ -1,13 +1,15 @@
 #pragma once
 
-#include <atomic>  // std::atomic
-#include <memory>  // std::shared_ptr
+#include <atomic>   // std::atomic
+#include <cstddef>  // std::size_t
+#include <memory>   // std::shared_ptr
 
 namespace Metrics {
 
 // forward declarations
 class ICounter;
 class IGauge;
+class DirtySet;
 
 std::shared_ptr<ICounter> createCounter();
 std::shared_ptr<IGauge> createGauge();
@@ -22,6 +24,13 @@ class IMetrics {
 public:
     virtual ~IMetrics() = default;
     virtual void accept(IMetricsVisitor&) = 0;
+
+    // Binds the metric to slot `slot` of `set`; every update marks the slot
+    // dirty. A metric is tracked by at most one set and one slot at a time:
+    // returns false if it is already bound elsewhere.
+    virtual bool track(std::shared_ptr<DirtySet> set, std::size_t slot) = 0;
+    // Releases the binding made by track(set, slot), if it is still current.
+    virtual void untrack(const DirtySet* set, std::size_t slot) = 0;
 };
 
 template <typename T>
@@ -31,12 +40,23 @@ protected:
     Wrapper(std::shared_ptr<T> value) : m_value(value) {}
 public:
     std::shared_ptr<T> get_ptr() { return m_value; }
+
+    bool track(std::shared_ptr<DirtySet> set, std::size_t slot) override {
+        return m_value->track(set, slot);
+    }
+    void untrack(const DirtySet* set, std::size_t slot) override {
+        m_value->untrack(set, slot);
+    }
 };
 
 class ICounter : public IMetrics,
                  public std::enable_shared_from_this<ICounter> {
 public:
+    // Count since the last reset.
     virtual uint64_t value() const = 0;
+    // Count since creation; reset() leaves it alone, so consumers that do
+    // not own the counter can take differences of it.
+    virtual uint64_t total() const = 0;
     virtual void reset() = 0;
     virtual ICounter& operator++(int) = 0;
     virtual ICounter& operator+=(uint64_t value) = 0;
@@ -67,6 +87,7 @@ public:
     Counter& operator=(Counter&&) = default;
 
     uint64_t value() const override { return m_value->value(); }
+    uint64_t total() const override { return m_value->total(); }
     void reset() { m_value->reset(); }
     ICounter& operator++(int) { return (*m_value)++; }
     ICounter& operator+=(uint64_t value) { return (*m_value += value); }
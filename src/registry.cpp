@@ -1,18 +1,349 @@
+#include <bit>         // std::bit_ceil
+#include <functional>  // std::hash
 #include <metrics.hpp>
 #include <registry.hpp>
 
 namespace Metrics {
 
+namespace {
+
+constexpr std::uintptr_t kRemoved = 1;
+constexpr std::size_t kNoSlot = static_cast<std::size_t>(-1);
+
+// Identifies registries to the cursors bound to them; never reused.
+std::atomic<uint64_t> g_next_id {1};
+
+template <typename T>
+T* unmarked(std::uintptr_t link) {
+    return reinterpret_cast<T*>(link & ~kRemoved);
+}
+
+}  // namespace
+
+Registry::Registry(std::size_t buckets, bool instrumented)
+    : m_id(g_next_id.fetch_add(1, std::memory_order_relaxed)),
+      m_instrumented(instrumented),
+      m_bucket_mask(std::bit_ceil(std::max<std::size_t>(buckets, 1)) - 1),
+      m_buckets(std::make_unique<std::atomic<std::uintptr_t>[]>(
+          m_bucket_mask + 1
+      )) {
+    attach(m_cursor);
+}
+
+Registry::~Registry() {
+    // Nodes still linked were never retired; unlinked ones belong to Epoch.
+    for (std::size_t b = 0; b <= m_bucket_mask; ++b) {
+        Node* node = unmarked<Node>(m_buckets[b].load());
+        while (node) {
+            const std::uintptr_t link = node->next.load();
+            Node* next = unmarked<Node>(link);
+            if constexpr (SelfStats::kEnabled) {
+                // marked nodes were accounted for when they were removed
+                if (m_instrumented && !(link & kRemoved)) {
+                    SelfStats::removed(nodeBytes(node));
+                }
+            }
+            delete node;
+            node = next;
+        }
+    }
+
+    // cursors may outlive the registry and keep their state
+    Subscriber* subscriber = m_subscribers.load();
+    while (subscriber) {
+        Subscriber* next = subscriber->next;
+        delete subscriber;
+        subscriber = next;
+    }
+}
+
+// Returns the first node of the bucket not ordered before (hash, name) and
+// points `prev` at the link leading to it. Removed nodes met on the way are
+// unlinked and retired. The caller must hold an Epoch::Guard.
+Registry::Node* Registry::search(
+    std::size_t hash, std::string_view name, std::atomic<std::uintptr_t>*& prev
+) {
+retry:
+    prev = &m_buckets[hash & m_bucket_mask];
+    std::uintptr_t link = prev->load(std::memory_order_acquire);
+
+    for (;;) {
+        if (link & kRemoved) {
+            countRetry();  // predecessor got removed
+            goto retry;
+        }
+        Node* curr = unmarked<Node>(link);
+        if (!curr) return nullptr;
+
+        const std::uintptr_t next = curr->next.load(std::memory_order_acquire);
+        if (next & kRemoved) {
+            std::uintptr_t expected = link;
+            if (!prev->compare_exchange_strong(
+                    expected, next & ~kRemoved, std::memory_order_acq_rel
+                )) {
+                countRetry();
+                goto retry;
+            }
+            Epoch::retire(curr);
+            link = next & ~kRemoved;
+            continue;
+        }
+
+        if (curr->hash > hash || (curr->hash == hash && curr->name >= name)) {
+            return curr;
+        }
+        prev = &curr->next;
+        link = next;
+    }
+}
+
+Registry::Node* Registry::find(std::string_view name) {
+    if constexpr (SelfStats::kEnabled) {
+        if (m_instrumented) SelfStats::lookup();
+    }
+
+    const std::size_t hash = std::hash<std::string_view> {}(name);
+    std::atomic<std::uintptr_t>* prev;
+    Node* node = search(hash, name, prev);
+    return node && node->hash == hash && node->name == name ? node : nullptr;
+}
+
+Registry::Node* Registry::insertOrGet(
+    std::string_view name, const std::shared_ptr<IMetrics>& metric
+) {
+    const std::size_t hash = std::hash<std::string_view> {}(name);
+    Node* fresh = nullptr;
+
+    for (;;) {
+        std::atomic<std::uintptr_t>* prev;
+        Node* curr = search(hash, name, prev);
+
+        if (curr && curr->hash == hash && curr->name == name) {
+            if (fresh) {
+                releaseSlot(fresh);
+                Epoch::retire(fresh);
+            }
+            return curr;
+        }
+
+        if (!fresh) {
+            fresh = createNode(name, hash, metric);
+            if (!fresh) return nullptr;
+        }
+
+        auto expected = reinterpret_cast<std::uintptr_t>(curr);
+        fresh->next.store(expected, std::memory_order_relaxed);
+        if (prev->compare_exchange_strong(
+                expected,
+                reinterpret_cast<std::uintptr_t>(fresh),
+                std::memory_order_acq_rel
+            )) {
+            fresh->live.store(true, std::memory_order_release);
+            // a fresh metric may already hold a value worth reporting
+            m_dirty->set(fresh->slot);
+
+            if constexpr (SelfStats::kEnabled) {
+                if (m_instrumented) SelfStats::inserted(nodeBytes(fresh));
+            }
+            return fresh;
+        }
+        countRetry();
+    }
+}
+
+bool Registry::removeNode(Node* node) {
+    std::uintptr_t next = node->next.load(std::memory_order_acquire);
+    do {
+        if (next & kRemoved) return false;  // someone else removed it
+    } while (!node->next.compare_exchange_weak(
+        next, next | kRemoved, std::memory_order_acq_rel
+    ));
+
+    releaseSlot(node);
+    if constexpr (SelfStats::kEnabled) {
+        if (m_instrumented) SelfStats::removed(nodeBytes(node));
+    }
+
+    // unlink it now rather than on the next lookup in this bucket
+    std::atomic<std::uintptr_t>* prev;
+    search(node->hash, node->name, prev);
+    return true;
+}
+
+// The node is visible to collect() through its slot before it is linked,
+// which is why collect() also checks Node::visible().
+Registry::Node* Registry::createNode(
+    std::string_view name,
+    std::size_t hash,
+    const std::shared_ptr<IMetrics>& metric
+) {
+    const std::size_t slot = allocSlot();
+    if (slot == kNoSlot) return nullptr;
+
+    Node* node = new Node {std::string(name), hash, metric, slot};
+    if (metric->track(m_dirty, slot)) {
+        m_untracked.clear(slot);
+    } else {
+        m_untracked.set(slot);
+    }
+    m_slots[slot].node.store(node, std::memory_order_release);
+    return node;
+}
+
+void Registry::releaseSlot(Node* node) {
+    m_slots[node->slot].node.store(nullptr, std::memory_order_release);
+    node->metric->untrack(m_dirty.get(), node->slot);
+    m_untracked.clear(node->slot);
+    freeSlot(node->slot);
+}
+
+std::size_t Registry::allocSlot() {
+    uint64_t head = m_free_slots.load(std::memory_order_acquire);
+    while (head & 0xffffffff) {
+        const std::size_t slot = (head & 0xffffffff) - 1;
+        const uint64_t next =
+            m_slots[slot].next_free.load(std::memory_order_relaxed);
+        const uint64_t tag = (head >> 32) + 1;
+        if (m_free_slots.compare_exchange_weak(
+                head, tag << 32 | next, std::memory_order_acq_rel
+            )) {
+            return slot;
+        }
+    }
+
+    const std::size_t slot =
+        m_slot_count.fetch_add(1, std::memory_order_acq_rel);
+    if (!m_slots.reserve(slot + 1) || !m_dirty->reserve(slot + 1) ||
+        !m_untracked.reserve(slot + 1)) {
+        return kNoSlot;
+    }
+    return slot;
+}
+
+void Registry::freeSlot(std::size_t slot) {
+    uint64_t head = m_free_slots.load(std::memory_order_relaxed);
+    uint64_t desired;
+    do {
+        m_slots[slot].next_free.store(
+            head & 0xffffffff, std::memory_order_relaxed
+        );
+        desired = ((head >> 32) + 1) << 32 | (slot + 1);
+    } while (!m_free_slots.compare_exchange_weak(
+        head, desired, std::memory_order_release, std::memory_order_relaxed
+    ));
+}
+
+std::size_t Registry::nodeBytes(const Node* node) const {
+    std::size_t bytes = sizeof(Node) + sizeof(Slot);
+    if constexpr (SelfStats::kEnabled) {
+        const std::size_t inline_capacity = std::string().capacity();
+        if (node->name.capacity() > inline_capacity) {
+            bytes += node->name.capacity() + 1;
+        }
+        bytes += SelfStats::metricBytes();
+    }
+    return bytes;
+}
+
+// Binds `cursor` to this registry, reusing the state of a released cursor
+// the way Epoch reuses thread records.
+DirtyCursor::State& Registry::attach(DirtyCursor& cursor) {
+    if (cursor.m_registry == m_id) return *cursor.m_state;
+    cursor.release();
+
+    std::shared_ptr<DirtyCursor::State> state;
+    for (Subscriber* s = m_subscribers.load(std::memory_order_acquire); s;
+         s = s->next) {
+        bool free = false;
+        if (!s->state->in_use.load(std::memory_order_relaxed) &&
+            s->state->in_use.compare_exchange_strong(
+                free, true, std::memory_order_acq_rel
+            )) {
+            s->state->fresh.store(true, std::memory_order_release);
+            state = s->state;
+            break;
+        }
+    }
+
+    if (!state) {
+        state = std::make_shared<DirtyCursor::State>();
+        auto* subscriber = new Subscriber {
+            state, m_subscribers.load(std::memory_order_relaxed)
+        };
+        while (!m_subscribers.compare_exchange_weak(
+            subscriber->next,
+            subscriber,
+            std::memory_order_release,
+            std::memory_order_relaxed
+        )) {
+        }
+    }
+
+    cursor.m_state = std::move(state);
+    cursor.m_registry = m_id;
+    return *cursor.m_state;
+}
+
+// Moves the bits set by metric updates into the bitmap of every cursor. A
+// cursor bound meanwhile may miss some, but it starts fresh anyway.
+void Registry::distribute(std::size_t slots) {
+    for (Subscriber* s = m_subscribers.load(std::memory_order_acquire); s;
+         s = s->next) {
+        if (s->state->in_use.load(std::memory_order_relaxed)) {
+            s->state->pending.reserve(slots);
+        }
+    }
+
+    const std::size_t words = DirtySet::wordsFor(slots);
+    for (std::size_t w = 0; w < words; ++w) {
+        const uint64_t bits = m_dirty->take(w);
+        if (!bits) continue;
+
+        for (Subscriber* s = m_subscribers.load(std::memory_order_acquire); s;
+             s = s->next) {
+            if (s->state->in_use.load(std::memory_order_relaxed)) {
+                s->state->pending.merge(w, bits);
+            }
+        }
+    }
+}
+
 void Registry::addMetric(
     std::string_view metric_name, const std::shared_ptr<IMetrics> metric_value
 ) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_metrics[std::string(metric_name)] = metric_value;
+    Epoch::Guard guard;
+    for (;;) {
+        Node* node = insertOrGet(metric_name, metric_value);
+        if (!node) {
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (node->metric == metric_value) return;
+        removeNode(node);
+    }
 };
 
+bool Registry::removeMetric(std::string_view metric_name) {
+    Epoch::Guard guard;
+    Node* node = find(metric_name);
+    return node && removeNode(node);
+}
+
 std::unordered_map<std::string, std::shared_ptr<IMetrics>>
 Registry::getMetricGroup() {
-    return m_metrics;
+    Epoch::Guard guard;
+    const std::size_t count =
+        std::min(m_slot_count.load(std::memory_order_acquire), kCapacity);
+
+    std::unordered_map<std::string, std::shared_ptr<IMetrics>> group;
+    group.reserve(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        Slot* slot = m_slots.at(i);
+        Node* node =
+            slot ? slot->node.load(std::memory_order_acquire) : nullptr;
+        if (node && node->visible()) group.emplace(node->name, node->metric);
+    }
+    return group;
 }
 
 std::shared_ptr<Registry> getRegistry() {
@@ -20,8 +351,8 @@ std::shared_ptr<Registry> getRegistry() {
     return newRegistry;
 }
 
-std::shared_ptr<Registry> createRegistry() {
-    return std::make_shared<Registry>();
+std::shared_ptr<Registry> createRegistry(std::size_t buckets) {
+    return std::make_shared<Registry>(buckets);
 }
 
 }  // namespace Metrics
\ No newline at end of file
@@ -1,51 +1,251 @@
 #pragma once
 
+#include <algorithm>  // std::min
+#include <atomic>     // std::atomic
+#include <bit>        // std::countr_zero
+#include <chunked_array.hpp>
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint64_t, std::uintptr_t
+#include <dirty_set.hpp>
 #include <dumper.hpp>
-#include <memory>  // std::shared_ptr
+#include <epoch.hpp>
+#include <memory>  // std::shared_ptr, std::unique_ptr
 #include <metrics.hpp>
-#include <mutex>          // std::mutex
+#include <optional>  // std::optional
+#include <self_stats.hpp>
 #include <string>         // std::string
 #include <string_view>    // std::string_view
 #include <unordered_map>  // std::unordered_map
+#include <utility>        // std::forward
 #include <visitors.hpp>
 
 namespace Metrics {
 
+// Why a lookup produced no metric.
+enum class LookupError {
+    None,
+    TypeMismatch,  // the name belongs to a metric of another type
+    Full,          // the registry already holds kCapacity metrics
+};
+
+// Result of Registry::getOrCreate: the metric, or the reason there is none.
+template <typename MetricType>
+struct Lookup {
+    std::optional<MetricType> metric;
+    LookupError error = LookupError::None;
+
+    bool has_value() const { return metric.has_value(); }
+    explicit operator bool() const { return metric.has_value(); }
+    MetricType& operator*() { return *metric; }
+    MetricType* operator->() { return &*metric; }
+};
+
+// Lock-free metric registry. Names are indexed by a fixed number of hash
+// buckets, each holding a sorted Harris-Michael list; every metric also owns
+// a slot used for dirty tracking and iteration. Lookups, registration,
+// removal and collection never block each other, and removed entries are
+// freed through Epoch once no reader can still see them.
 class Registry {
+public:
+    static constexpr std::size_t kDefaultBuckets = 4096;
+    static constexpr std::size_t kCapacity = DirtySet::kCapacity;
 private:
-    std::mutex m_mutex;
-    std::unordered_map<std::string, std::shared_ptr<IMetrics>> m_metrics;
+    struct Node {
+        const std::string name;
+        const std::size_t hash;
+        const std::shared_ptr<IMetrics> metric;
+        const std::size_t slot;
+        // successor, low bit set once the node is removed
+        std::atomic<std::uintptr_t> next {0};
+        // set once the node is reachable from its bucket
+        std::atomic<bool> live {false};
+
+        bool visible() const {
+            return live.load(std::memory_order_acquire) &&
+                   !(next.load(std::memory_order_acquire) & 1);
+        }
+    };
+
+    struct Slot {
+        std::atomic<Node*> node {nullptr};
+        std::atomic<uint64_t> next_free {0};
+    };
+
+    // Pending bits of one DirtyCursor; links are reused once it is gone.
+    struct Subscriber {
+        const std::shared_ptr<DirtyCursor::State> state;
+        Subscriber* next;
+    };
+
+    const uint64_t m_id;
+    const bool m_instrumented;
+    const std::size_t m_bucket_mask;
+    std::unique_ptr<std::atomic<std::uintptr_t>[]> m_buckets;
+    ChunkedArray<Slot, DirtySet::kSlotsPerChunk, DirtySet::kMaxChunks> m_slots;
+    // slots handed out so far; freed ones are reused through m_free_slots
+    std::atomic<std::size_t> m_slot_count {0};
+    // Treiber stack of free slots: ABA tag in the high half, index + 1 low
+    std::atomic<uint64_t> m_free_slots {0};
+    std::shared_ptr<DirtySet> m_dirty = std::make_shared<DirtySet>();
+    // Slots whose metric is bound to another registry's DirtySet (or to
+    // another slot of this one); they are reported as changed every time.
+    DirtySet m_untracked;
+    std::atomic<uint64_t> m_rejected {0};
+    std::atomic<Subscriber*> m_subscribers {nullptr};
+    // used by collect() calls that bring no cursor of their own
+    DirtyCursor m_cursor;
+
+    Node* search(
+        std::size_t hash,
+        std::string_view name,
+        std::atomic<std::uintptr_t>*& prev
+    );
+    Node* find(std::string_view name);
+    Node* insertOrGet(
+        std::string_view name, const std::shared_ptr<IMetrics>& metric
+    );
+    bool removeNode(Node* node);
+
+    Node* createNode(
+        std::string_view name,
+        std::size_t hash,
+        const std::shared_ptr<IMetrics>& metric
+    );
+    void releaseSlot(Node* node);
+    std::size_t allocSlot();
+    void freeSlot(std::size_t slot);
+    std::size_t nodeBytes(const Node* node) const;
+
+    DirtyCursor::State& attach(DirtyCursor& cursor);
+    void distribute(std::size_t slots);
+
+    void countRetry() const {
+        if constexpr (SelfStats::kEnabled) {
+            if (m_instrumented) SelfStats::retry();
+        }
+    }
 public:
+    // Registries built with `instrumented` false are left out of SelfStats.
+    explicit Registry(
+        std::size_t buckets = kDefaultBuckets, bool instrumented = true
+    );
+    ~Registry();
+
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+    // Registers `metric_value` under `metric_name`, replacing any metric
+    // already registered under that name. Counted in rejected() if the
+    // registry is full.
     void addMetric(
         std::string_view metric_name,
         const std::shared_ptr<IMetrics> metric_value
     );
 
+    // Unregisters `metric_name`. Returns false if it was not registered.
+    bool removeMetric(std::string_view metric_name);
+
+    // Returns the metric registered under `metric_name`, registering a new
+    // one if there is none. Fails with LookupError::TypeMismatch if the name
+    // is taken by a metric of another type and with LookupError::Full if the
+    // registry has no room for a new one.
     template <typename MetricType>
-    MetricType getMetric(std::string_view metric_name) {
+    Lookup<MetricType> getOrCreate(std::string_view metric_name) {
         static_assert(
             std::is_same_v<MetricType, Counter> ||
                 std::is_same_v<MetricType, Gauge>,
             "Unsupported metric type"
         );
 
-        std::lock_guard<std::mutex> lock(m_mutex);
-        std::string key {metric_name};
-
-        if (m_metrics.find(key) == m_metrics.end()) {
-            m_metrics[key] = std::make_shared<MetricType>();
+        Epoch::Guard guard;
+        Node* node = find(metric_name);
+        if (!node) {
+            MetricType created;
+            node = insertOrGet(metric_name, created.get_ptr());
+            if (!node) return {std::nullopt, LookupError::Full};
         }
 
         Metrics::ValueVisitor<MetricType> visitor;
-        m_metrics[key]->accept(visitor);
+        node->metric->accept(visitor);
+        if (!visitor.matched()) {
+            return {std::nullopt, LookupError::TypeMismatch};
+        }
+
+        return {visitor.getResult()};
+    }
+
+    // Like getOrCreate, but a failure yields a detached metric that no
+    // registry reports, counted in rejected().
+    template <typename MetricType>
+    MetricType getMetric(std::string_view metric_name) {
+        Lookup<MetricType> lookup = getOrCreate<MetricType>(metric_name);
+        if (lookup) return *lookup;
+
+        m_rejected.fetch_add(1, std::memory_order_relaxed);
+        return MetricType();
+    }
 
-        return visitor.getResult();
+    // Metrics getMetric() handed out detached and addMetric() dropped.
+    uint64_t rejected() const {
+        return m_rejected.load(std::memory_order_relaxed);
     }
 
     std::unordered_map<std::string, std::shared_ptr<IMetrics>> getMetricGroup();
+
+    // Calls fn(name, metric, changed) for every metric updated since the
+    // previous collection through `cursor`; the first collection through a
+    // cursor reports every metric. Cost is proportional to the number of
+    // changed metrics plus a few word operations per 64 slots and cursor.
+    // With `include_clean` unchanged metrics are passed as well. Metrics may
+    // be added or removed concurrently; those passed to fn stay alive until
+    // collect returns.
+    template <typename Fn>
+    void collect(DirtyCursor& cursor, Fn&& fn, bool include_clean = false) {
+        {
+            Epoch::Guard guard;
+            DirtyCursor::State& state = attach(cursor);
+            const std::size_t slots = std::min(
+                m_slot_count.load(std::memory_order_acquire), kCapacity
+            );
+            const std::size_t words = DirtySet::wordsFor(slots);
+
+            distribute(slots);
+            const bool fresh =
+                state.fresh.exchange(false, std::memory_order_acq_rel);
+
+            for (std::size_t w = 0; w < words; ++w) {
+                uint64_t changed = state.pending.take(w) | m_untracked.peek(w);
+                if (fresh) changed = ~uint64_t {0};
+                uint64_t visit = include_clean ? ~uint64_t {0} : changed;
+
+                while (visit) {
+                    const int bit = std::countr_zero(visit);
+                    visit &= visit - 1;
+
+                    Slot* slot = m_slots.at(w * DirtySet::kBitsPerWord + bit);
+                    Node* node =
+                        slot ? slot->node.load(std::memory_order_acquire)
+                             : nullptr;
+                    if (!node || !node->visible()) continue;
+
+                    fn(node->name, node->metric, ((changed >> bit) & 1) != 0);
+                }
+            }
+        }
+        Epoch::reclaim();
+    }
+
+    // Collects through a cursor shared by every caller that omits one, so
+    // those callers split the changes between them.
+    template <typename Fn>
+    void collect(Fn&& fn, bool include_clean = false) {
+        collect(m_cursor, std::forward<Fn>(fn), include_clean);
+    }
 };
 
 std::shared_ptr<Registry> getRegistry();
-std::shared_ptr<Registry> createRegistry();
+std::shared_ptr<Registry> createRegistry(
+    std::size_t buckets = Registry::kDefaultBuckets
+);
 
 }  // namespace Metrics
\ No newline at end of file
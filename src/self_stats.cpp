@@ -0,0 +1,132 @@
+#include <atomic>  // std::atomic
+#include <metrics.hpp>
+#include <registry.hpp>
+#include <self_stats.hpp>
+
+namespace Metrics {
+
+namespace SelfStats {
+
+#ifdef METRICS_CPP_SELF_STATS
+namespace {
+
+// Gauge that reports a live level. Dumps read it but cannot reset it, and it
+// is never tracked as dirty, so registries report it on every collection.
+class LevelGauge : public IGauge {
+private:
+    double (*m_read)();
+public:
+    LevelGauge(double (*read)()) : m_read(read) {}
+
+    double value() const override { return m_read(); }
+    void reset() override {}
+    IGauge& operator+=(double) override { return *this; }
+    IGauge& operator-=(double) override { return *this; }
+
+    bool track(std::shared_ptr<DirtySet>, std::size_t) override {
+        return false;
+    }
+    void untrack(const DirtySet*, std::size_t) override {}
+};
+
+struct State {
+    Counter lookups;
+    Counter retries;
+    Counter inserts;
+    Counter removals;
+    Counter dump_writes;
+    Counter dump_ns;
+    Counter dump_bytes;
+
+    std::atomic<int64_t> series {0};
+    std::atomic<int64_t> bytes {0};
+
+    // left uninstrumented, or registering its own metrics would recurse
+    std::shared_ptr<Registry> registry = std::make_shared<Registry>(64, false);
+
+    State();
+};
+
+// Leaked on purpose: registries with static storage, getRegistry()'s among
+// them, may be destroyed after any function-local static of ours and still
+// report their series on the way out.
+State& state() {
+    static State* s = new State;
+    return *s;
+}
+
+State::State() {
+    registry->addMetric("metrics.registry.lookups", lookups.get_ptr());
+    registry->addMetric("metrics.registry.retries", retries.get_ptr());
+    registry->addMetric("metrics.registry.inserts", inserts.get_ptr());
+    registry->addMetric("metrics.registry.removals", removals.get_ptr());
+    registry->addMetric("metrics.dumper.writes", dump_writes.get_ptr());
+    registry->addMetric("metrics.dumper.write_ns", dump_ns.get_ptr());
+    registry->addMetric("metrics.dumper.bytes", dump_bytes.get_ptr());
+
+    // `state()` is fully constructed by the time these are read
+    registry->addMetric(
+        "metrics.registry.series",
+        std::make_shared<LevelGauge>([] {
+            return static_cast<double>(state().series.load());
+        })
+    );
+    registry->addMetric(
+        "metrics.registry.bytes",
+        std::make_shared<LevelGauge>([] {
+            return static_cast<double>(state().bytes.load());
+        })
+    );
+    registry->addMetric(
+        "metrics.registry.bytes_per_metric",
+        std::make_shared<LevelGauge>([] {
+            const int64_t series = state().series.load();
+            return series > 0 ? static_cast<double>(state().bytes.load()) /
+                                    static_cast<double>(series)
+                              : 0.0;
+        })
+    );
+}
+
+}  // namespace
+
+void lookup() { state().lookups++; }
+
+void retry() { state().retries++; }
+
+void inserted(std::size_t bytes) {
+    State& s = state();
+    s.inserts++;
+    s.series.fetch_add(1, std::memory_order_relaxed);
+    s.bytes.fetch_add(
+        static_cast<int64_t>(bytes), std::memory_order_relaxed
+    );
+}
+
+void removed(std::size_t bytes) {
+    State& s = state();
+    s.removals++;
+    s.series.fetch_sub(1, std::memory_order_relaxed);
+    s.bytes.fetch_sub(
+        static_cast<int64_t>(bytes), std::memory_order_relaxed
+    );
+}
+
+void dumped(std::chrono::nanoseconds duration, std::size_t bytes) {
+    State& s = state();
+    s.dump_writes++;
+    s.dump_ns += static_cast<uint64_t>(duration.count());
+    s.dump_bytes += bytes;
+}
+
+std::shared_ptr<Registry> getSelfRegistry() { return state().registry; }
+#else
+std::shared_ptr<Registry> getSelfRegistry() {
+    static std::shared_ptr<Registry> empty = createRegistry(1);
+    return empty;
+}
+#endif
+
+}  // namespace SelfStats
+
+}  // namespace Metrics
\ No newline at end of file
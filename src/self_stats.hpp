@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>   // std::chrono::nanoseconds
+#include <cstddef>  // std::size_t
+#include <memory>   // std::shared_ptr
+
+namespace Metrics {
+
+// forward declaration
+class Registry;
+
+// Accounting of the library's own overhead, enabled by building with
+// METRICS_CPP_SELF_STATS (CMake option of the same name). Without it every
+// hook below is an empty inline function and callers skip the measurements
+// behind `if constexpr (SelfStats::kEnabled)`.
+namespace SelfStats {
+
+#ifdef METRICS_CPP_SELF_STATS
+inline constexpr bool kEnabled = true;
+
+void lookup();
+void retry();
+void inserted(std::size_t bytes);
+void removed(std::size_t bytes);
+void dumped(std::chrono::nanoseconds duration, std::size_t bytes);
+
+// Heap footprint of one metric object, defined next to the implementations.
+std::size_t metricBytes();
+#else
+inline constexpr bool kEnabled = false;
+
+inline void lookup() {}
+inline void retry() {}
+inline void inserted(std::size_t) {}
+inline void removed(std::size_t) {}
+inline void dumped(std::chrono::nanoseconds, std::size_t) {}
+
+inline std::size_t metricBytes() { return 0; }
+#endif
+
+// Registry holding the statistics; it stays empty unless they are enabled.
+// It can be dumped like any other registry.
+std::shared_ptr<Registry> getSelfRegistry();
+
+}  // namespace SelfStats
+
+}  // namespace Metrics
\ No newline at end of file
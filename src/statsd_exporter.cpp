@@ -0,0 +1,340 @@
+#include <algorithm>  // std::clamp, std::fill
+#include <charconv>   // std::to_chars
+#include <cmath>      // std::isfinite
+#include <cstring>    // std::memcpy
+#include <metrics.hpp>
+#include <registry.hpp>
+#include <statsd_exporter.hpp>
+
+#ifdef _WIN32
+#include <winsock2.h>  // socket, send, closesocket
+#include <ws2tcpip.h>  // getaddrinfo
+#else
+#include <netdb.h>       // getaddrinfo
+#include <sys/socket.h>  // socket, connect, send, sendmmsg
+#include <unistd.h>      // close
+#include <cerrno>        // errno, EINTR
+#endif
+
+namespace Metrics {
+
+namespace {
+
+#ifdef _WIN32
+using Socket = SOCKET;
+
+bool startNetworking() {
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+
+void closeSocketHandle(std::intptr_t fd) {
+    closesocket(static_cast<Socket>(fd));
+}
+#else
+using Socket = int;
+
+bool startNetworking() { return true; }
+
+void closeSocketHandle(std::intptr_t fd) { ::close(static_cast<Socket>(fd)); }
+#endif
+
+// UDP socket connected to host:port, or -1.
+std::intptr_t connectUdp(std::string_view host, uint16_t port) {
+    if (!startNetworking()) return -1;
+
+    addrinfo hints {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    addrinfo* found = nullptr;
+    const std::string node(host);
+    const std::string service = std::to_string(port);
+    if (getaddrinfo(node.c_str(), service.c_str(), &hints, &found)) {
+        return -1;
+    }
+
+    std::intptr_t result = -1;
+    for (addrinfo* ai = found; ai && result < 0; ai = ai->ai_next) {
+        Socket fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+#ifdef _WIN32
+        if (fd == INVALID_SOCKET) continue;
+        if (connect(fd, ai->ai_addr, static_cast<int>(ai->ai_addrlen)) == 0) {
+#else
+        if (fd < 0) continue;
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+#endif
+            result = static_cast<std::intptr_t>(fd);
+        } else {
+            closeSocketHandle(static_cast<std::intptr_t>(fd));
+        }
+    }
+    freeaddrinfo(found);
+    return result;
+}
+
+struct SendResult {
+    std::size_t packets = 0;
+    std::size_t lines = 0;
+};
+
+// Sends packets [0, count) of `buffer`, each `stride` bytes apart and
+// holding lines[i] lines. Returns what the kernel accepted.
+SendResult sendPackets(
+    std::intptr_t fd,
+    const char* buffer,
+    std::size_t stride,
+    const std::size_t* lengths,
+    const std::size_t* lines,
+    std::size_t count
+) {
+    SendResult sent;
+#ifdef __linux__
+    mmsghdr msgs[StatsdExporter::kMaxBatch] {};
+    iovec iov[StatsdExporter::kMaxBatch];
+    for (std::size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = const_cast<char*>(buffer + i * stride);
+        iov[i].iov_len = lengths[i];
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for (std::size_t done = 0; done < count;) {
+        const int n = ::sendmmsg(
+            static_cast<Socket>(fd),
+            msgs + done,
+            static_cast<unsigned>(count - done),
+            0
+        );
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ++done;  // skip the packet the kernel refused
+            continue;
+        }
+        const std::size_t end = done + static_cast<std::size_t>(n);
+        for (; done < end; ++done) {
+            ++sent.packets;
+            sent.lines += lines[done];
+        }
+    }
+#else
+    for (std::size_t i = 0; i < count; ++i) {
+        const auto n = ::send(
+            static_cast<Socket>(fd),
+            buffer + i * stride,
+            static_cast<int>(lengths[i]),
+            0
+        );
+        if (n >= 0) {
+            ++sent.packets;
+            sent.lines += lines[i];
+        }
+    }
+#endif
+    return sent;
+}
+
+// StatsD reserves ':', '|', '@' and newlines; spaces are also replaced.
+void appendName(std::string& line, std::string_view name) {
+    for (char c : name) {
+        const bool reserved =
+            c == ':' || c == '|' || c == '@' || c == '\n' || c == ' ';
+        line.push_back(reserved ? '_' : c);
+    }
+}
+
+template <typename T>
+void appendNumber(std::string& line, T value) {
+    char digits[32];
+    auto [end, err] = std::to_chars(digits, digits + sizeof(digits), value);
+    line.append(digits, err == std::errc() ? end : digits);
+}
+
+}  // namespace
+
+// Formats "value|type" for a metric. Counters are read once and diffed
+// against what this exporter sent before, so an increment is never lost
+// between reading and resetting, and the counter stays untouched.
+class StatsdExporter::LineVisitor : public IMetricsVisitor {
+private:
+    StatsdExporter& m_exporter;
+    const std::string* m_name = nullptr;
+    bool m_sendable = true;
+public:
+    LineVisitor(StatsdExporter& exporter) : m_exporter(exporter) {}
+
+    void setMetricName(const std::string& name) {
+        m_name = &name;
+        m_sendable = true;
+    }
+
+    // False if the metric has no value StatsD can represent.
+    bool sendable() const { return m_sendable; }
+
+    void visit(std::shared_ptr<ICounter> counter) override {
+        const uint64_t total = counter->total();
+        SentCounter& sent =
+            m_exporter.m_sent.try_emplace(*m_name, SentCounter {0, 0})
+                .first->second;
+        // a smaller total means another counter took over the name
+        const uint64_t delta =
+            total >= sent.total ? total - sent.total : total;
+        sent = {total, m_exporter.m_writes};
+
+        appendNumber(m_exporter.m_line, delta);
+        m_exporter.m_line += "|c";
+    }
+
+    // A signed gauge value is an adjustment in StatsD, so a negative level
+    // is sent as "name:0|g" followed by "name:-3.5|g" in the same packet.
+    void visit(std::shared_ptr<IGauge> gauge) override {
+        std::string& line = m_exporter.m_line;
+        double value = gauge->value();
+        if (!std::isfinite(value)) {
+            m_sendable = false;
+            return;
+        }
+        if (value == 0) value = 0;  // no "-0"
+
+        if (value < 0) {
+            const std::size_t head = line.size();  // "<prefix><name>:"
+            line += "0|g\n";
+            line.append(line, 0, head);
+        }
+        appendNumber(line, value);
+        line += "|g";
+    }
+};
+
+StatsdExporter::StatsdExporter(
+    std::string_view host, uint16_t port, StatsdOptions options
+)
+    : m_options(std::move(options)),
+      m_batch(std::clamp<std::size_t>(m_options.batch, 1, kMaxBatch)),
+      m_socket(connectUdp(host, port)),
+      m_buffer(m_batch * m_options.max_packet),
+      m_lengths(m_batch, 0),
+      m_lines(m_batch, 0) {
+    m_line.reserve(m_options.max_packet);
+}
+
+void StatsdExporter::closeSocket() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::intptr_t fd = m_socket.exchange(-1);
+    if (fd >= 0) closeSocketHandle(fd);
+}
+
+void StatsdExporter::write(std::shared_ptr<Metrics::Registry> registry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_socket.load() < 0) return;
+
+    ++m_writes;
+    const bool sparse = m_options.mode == DumpMode::Sparse;
+    const bool sweep = !sparse || m_writes % kSweepEvery == 0;
+
+    LineVisitor visitor(*this);
+
+    registry->collect(
+        m_cursor,
+        [&](const std::string& metric_name,
+            const std::shared_ptr<IMetrics>& metric_value,
+            bool changed) {
+            if (sparse && !changed) {
+                // only reached when sweeping: keep the counter's history
+                auto it = m_sent.find(metric_name);
+                if (it != m_sent.end()) it->second.write = m_writes;
+                return;
+            }
+
+            m_line.clear();
+            m_line += m_options.prefix;
+            appendName(m_line, metric_name);
+            m_line += ':';
+            visitor.setMetricName(metric_name);
+            metric_value->accept(visitor);
+            if (visitor.sendable()) {
+                append(m_line);
+            } else {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+            }
+        },
+        sweep
+    );
+
+    flush();
+
+    if (sweep) {
+        std::erase_if(m_sent, [this](const auto& entry) {
+            return entry.second.write != m_writes;
+        });
+    }
+}
+
+void StatsdExporter::append(std::string_view line) {
+    const std::size_t max_packet = m_options.max_packet;
+    if (line.size() > max_packet) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (m_lengths[m_packets] > 0 &&
+        m_lengths[m_packets] + 1 + line.size() > max_packet) {
+        if (++m_packets == m_batch) flush();
+    }
+
+    char* packet = m_buffer.data() + m_packets * max_packet;
+    std::size_t& length = m_lengths[m_packets];
+    if (length > 0) packet[length++] = '\n';
+    std::memcpy(packet + length, line.data(), line.size());
+    length += line.size();
+    ++m_lines[m_packets];
+}
+
+void StatsdExporter::flush() {
+    const std::size_t count =
+        m_packets + (m_packets < m_batch && m_lengths[m_packets] > 0);
+    if (count > 0) {
+        const SendResult sent = sendPackets(
+            m_socket.load(),
+            m_buffer.data(),
+            m_options.max_packet,
+            m_lengths.data(),
+            m_lines.data(),
+            count
+        );
+        m_packets_sent.fetch_add(sent.packets, std::memory_order_relaxed);
+        m_metrics_sent.fetch_add(sent.lines, std::memory_order_relaxed);
+        m_dropped.fetch_add(count - sent.packets, std::memory_order_relaxed);
+    }
+
+    m_packets = 0;
+    std::fill(m_lengths.begin(), m_lengths.end(), 0);
+    std::fill(m_lines.begin(), m_lines.end(), 0);
+}
+
+void StatsdExporter::enableAutoWrite(
+    std::shared_ptr<Metrics::Registry> registry, std::chrono::seconds interval
+) {
+    if (m_worker.joinable()) return;
+
+    auto weak_self = weak_from_this();
+
+    m_worker =
+        std::jthread([weak_self, registry, interval](std::stop_token st) {
+            while (!st.stop_requested()) {
+                if (auto self = weak_self.lock()) {
+                    self->write(registry);
+                } else {
+                    break;
+                }
+                std::this_thread::sleep_for(interval);
+            }
+        });
+}
+
+void StatsdExporter::disableAutoWrite() { m_worker.request_stop(); }
+
+}  // namespace Metrics
\ No newline at end of file
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>   // std::atomic
+#include <chrono>   // std::chrono::seconds
+#include <cstddef>  // std::size_t
+#include <cstdint>  // uint16_t, uint64_t, std::intptr_t
+#include <dirty_set.hpp>
+#include <dumper.hpp>     // DumpMode
+#include <memory>         // std::shared_ptr
+#include <mutex>          // std::mutex
+#include <string>         // std::string
+#include <string_view>    // std::string_view
+#include <thread>         // std::jthread
+#include <unordered_map>  // std::unordered_map
+#include <vector>         // std::vector
+
+namespace Metrics {
+
+// forward declaration
+class Registry;
+
+struct StatsdOptions {
+    // Largest UDP payload; the default leaves room for IP and UDP headers
+    // within a 1500 byte Ethernet MTU.
+    std::size_t max_packet = 1432;
+    // Packets handed to the kernel per sendmmsg call, at most kMaxBatch.
+    std::size_t batch = 32;
+    // Prepended to every metric name, e.g. "myapp.".
+    std::string prefix;
+    // Sparse sends only metrics changed since the previous write.
+    DumpMode mode = DumpMode::Sparse;
+};
+
+// Pushes registry contents to a StatsD / DogStatsD agent over UDP. Counters
+// are sent as their growth since this exporter last sent them ("name:5|c"),
+// without resetting them, so other sinks see the same increments; gauges
+// are sent as their current value ("name:0.97|g"). Lines are packed into
+// packets of at most max_packet bytes, never split across packets, and sent
+// in batches from buffers allocated once.
+class StatsdExporter : public std::enable_shared_from_this<StatsdExporter> {
+public:
+    static constexpr std::size_t kMaxBatch = 64;
+    // Sparse exports look at every metric once per this many writes, to
+    // forget counters that are no longer registered.
+    static constexpr uint64_t kSweepEvery = 64;
+private:
+    class LineVisitor;
+
+    struct SentCounter {
+        uint64_t total;  // ICounter::total() when last sent
+        uint64_t write;  // write that last saw the counter
+    };
+
+    const StatsdOptions m_options;
+    const std::size_t m_batch;
+    std::atomic<std::intptr_t> m_socket {-1};
+
+    std::mutex m_mutex;
+    DirtyCursor m_cursor;
+    std::vector<char> m_buffer;
+    std::vector<std::size_t> m_lengths;
+    std::vector<std::size_t> m_lines;  // metrics in each packet
+    std::string m_line;
+    std::size_t m_packets = 0;  // packets filled in the current batch
+    std::unordered_map<std::string, SentCounter> m_sent;
+    uint64_t m_writes = 0;
+
+    std::atomic<uint64_t> m_packets_sent {0};
+    std::atomic<uint64_t> m_metrics_sent {0};
+    std::atomic<uint64_t> m_dropped {0};
+
+    std::jthread m_worker;
+
+    void append(std::string_view line);
+    void flush();
+    void closeSocket();
+public:
+    StatsdExporter(
+        std::string_view host, uint16_t port, StatsdOptions options = {}
+    );
+
+    ~StatsdExporter() {
+        disableAutoWrite();
+        closeSocket();
+    }
+
+    StatsdExporter(const StatsdExporter&) = delete;
+    StatsdExporter& operator=(const StatsdExporter&) = delete;
+
+    bool is_open() const { return m_socket >= 0; }
+
+    void write(std::shared_ptr<Metrics::Registry> registry);
+    void enableAutoWrite(
+        std::shared_ptr<Metrics::Registry> registry,
+        std::chrono::seconds interval
+    );
+    void disableAutoWrite();
+    void reset() {
+        disableAutoWrite();
+        closeSocket();
+    }
+
+    uint64_t packetsSent() const { return m_packets_sent.load(); }
+    // Metrics in packets the kernel accepted.
+    uint64_t metricsSent() const { return m_metrics_sent.load(); }
+    // Lines longer than max_packet, non-finite gauges and packets the kernel
+    // refused.
+    uint64_t dropped() const { return m_dropped.load(); }
+};
+
+}  // namespace Metrics
\ No newline at end of file
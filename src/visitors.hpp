@@ -1,6 +1,7 @@
 #pragma once
 
 #include <metrics.hpp>
+#include <optional>     // std::optional
 #include <sstream>      // std::ostringstream
 #include <type_traits>  // std::is_same_v
 
@@ -9,21 +10,24 @@ namespace Metrics {
 template <typename MetricType>
 class ValueVisitor : public IMetricsVisitor {
 private:
-    MetricType m_value;
+    std::optional<MetricType> m_value;
 public:
     void visit(std::shared_ptr<ICounter> counter) override {
         if constexpr (std::is_same_v<MetricType, Counter>) {
-            m_value = MetricType(counter);
+            m_value.emplace(counter);
         }
     }
 
     void visit(std::shared_ptr<IGauge> gauge) override {
         if constexpr (std::is_same_v<MetricType, Gauge>) {
-            m_value = MetricType(gauge);
+            m_value.emplace(gauge);
         }
     }
 
-    MetricType getResult() const { return m_value; }
+    // False if the visited metric is not a MetricType.
+    bool matched() const { return m_value.has_value(); }
+
+    MetricType getResult() const { return m_value ? *m_value : MetricType(); }
 };
 
 class ResetVisitor : public IMetricsVisitor {
@@ -32,6 +36,14 @@ public:
     void visit(std::shared_ptr<IGauge> counter) override { counter->reset(); }
 };
 
+// Resets counters only: a gauge holds a level that other sinks may still
+// need, not an amount accumulated since the last write.
+class CounterResetVisitor : public IMetricsVisitor {
+public:
+    void visit(std::shared_ptr<ICounter> counter) override { counter->reset(); }
+    void visit(std::shared_ptr<IGauge>) override {}
+};
+
 class StringValueVisitor : public IMetricsVisitor {
 private:
     std::ostringstream m_stream;
@@ -65,6 +65,75 @@ TEST_CASE("Dumper basic functionality", "[dumper]") {
         REQUIRE(content.find("auto_counter") != std::string::npos);
     }
 
+    SECTION("Sparse mode writes only changed metrics") {
+        const std::string sparse_filename = "dumper_sparse_test.txt";
+        auto sparse = std::make_shared<Metrics::Dumper>(
+            sparse_filename, Metrics::DumpMode::Sparse
+        );
+
+        auto busy = reg->getMetric<Metrics::Counter>("busy");
+        reg->getMetric<Metrics::Counter>("quiet");
+        sparse->write(reg);
+
+        busy += 7;
+        sparse->write(reg);
+        sparse->reset();
+
+        std::ifstream file(sparse_filename);
+        std::string first, second;
+        std::getline(file, first);
+        std::getline(file, second);
+        file.close();
+
+        REQUIRE(first.find("\"quiet\" 0") != std::string::npos);
+        REQUIRE(second.find("\"busy\" 7") != std::string::npos);
+        REQUIRE(second.find("quiet") == std::string::npos);
+
+        std::filesystem::remove(sparse_filename);
+    }
+
+    SECTION("Counters are reset by a write, gauges keep their level") {
+        auto requests = reg->getMetric<Metrics::Counter>("requests");
+        auto load = reg->getMetric<Metrics::Gauge>("load");
+        requests += 3;
+        load += 0.75;
+
+        dumper->write(reg);
+        REQUIRE(requests.value() == 0);
+        REQUIRE(load.value() == 0.75);
+    }
+
+    SECTION("Sparse dumpers sharing a registry both see a change") {
+        const std::string first_filename = "dumper_first_test.txt";
+        const std::string second_filename = "dumper_second_test.txt";
+        auto first = std::make_shared<Metrics::Dumper>(
+            first_filename, Metrics::DumpMode::Sparse
+        );
+        auto second = std::make_shared<Metrics::Dumper>(
+            second_filename, Metrics::DumpMode::Sparse
+        );
+
+        auto hits = reg->getMetric<Metrics::Counter>("hits");
+        first->write(reg);
+        second->write(reg);
+
+        hits += 10;
+        first->write(reg);
+        second->write(reg);
+        first->reset();
+        second->reset();
+
+        for (const auto& filename : {first_filename, second_filename}) {
+            std::ifstream file(filename);
+            std::string line;
+            std::getline(file, line);
+            std::getline(file, line);
+            REQUIRE(line.find("\"hits\"") != std::string::npos);
+            file.close();
+            std::filesystem::remove(filename);
+        }
+    }
+
     SECTION("Reset functionality") {
         dumper->write(reg);
         REQUIRE(std::filesystem::exists(test_filename));
@@ -0,0 +1,55 @@
+#include <atomic>
+#include <catch2/catch_test_macros.hpp>
+#include <epoch.hpp>
+#include <thread>
+
+namespace {
+
+struct Tracked {
+    std::atomic<int>& destroyed;
+    ~Tracked() { destroyed++; }
+};
+
+}  // namespace
+
+TEST_CASE("Epoch reclamation", "[epoch]") {
+    std::atomic<int> destroyed {0};
+
+    SECTION("Objects outlive readers pinned before retirement") {
+        std::atomic<bool> pinned {false};
+        std::atomic<bool> release {false};
+
+        std::thread reader([&] {
+            Metrics::Epoch::Guard guard;
+            pinned = true;
+            while (!release) std::this_thread::yield();
+        });
+        while (!pinned) std::this_thread::yield();
+
+        Metrics::Epoch::retire(new Tracked {destroyed});
+        for (int i = 0; i < 8; ++i) Metrics::Epoch::reclaim();
+        REQUIRE(destroyed == 0);
+
+        release = true;
+        reader.join();
+
+        for (int i = 0; i < 8; ++i) Metrics::Epoch::reclaim();
+        REQUIRE(destroyed == 1);
+    }
+
+    SECTION("Nested guards") {
+        {
+            Metrics::Epoch::Guard outer;
+            {
+                Metrics::Epoch::Guard inner;
+            }
+            Metrics::Epoch::retire(new Tracked {destroyed});
+            Metrics::Epoch::reclaim();
+            Metrics::Epoch::reclaim();
+            Metrics::Epoch::reclaim();
+            REQUIRE(destroyed == 0);  // still pinned by outer
+        }
+        for (int i = 0; i < 8; ++i) Metrics::Epoch::reclaim();
+        REQUIRE(destroyed == 1);
+    }
+}
\ No newline at end of file
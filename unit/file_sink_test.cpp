@@ -0,0 +1,162 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <file_sink.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+std::string readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>()
+    );
+}
+
+}  // namespace
+
+TEST_CASE("FileSink durable writes", "[file_sink]") {
+    const std::filesystem::path dir = "file_sink_test";
+    const std::filesystem::path path = dir / "metrics.txt";
+
+    // Clean up test directory
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+
+    SECTION("Appends to an existing file") {
+        {
+            Metrics::FileSink sink(path.string());
+            REQUIRE(sink.write("first\n"));
+        }
+        {
+            Metrics::FileSink sink(path.string());
+            REQUIRE(sink.write("second\n"));
+        }
+        REQUIRE(readFile(path) == "first\nsecond\n");
+    }
+
+    SECTION("Partial trailing record is dropped on open") {
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << "complete\ntorn rec";
+        }
+
+        Metrics::FileSink sink(path.string());
+        sink.write("next\n");
+        sink.close();
+
+        REQUIRE(readFile(path) == "complete\nnext\n");
+    }
+
+    SECTION("Size based rotation keeps whole records") {
+        Metrics::FileSinkOptions options;
+        options.max_bytes = 10;
+
+        Metrics::FileSink sink(path.string(), options);
+        sink.write("aaaa\n");
+        sink.write("bbbb\n");
+        sink.write("cccc\n");  // would exceed 10 bytes
+        sink.close();
+
+        REQUIRE(readFile(path.string() + ".1") == "aaaa\nbbbb\n");
+        REQUIRE(readFile(path) == "cccc\n");
+    }
+
+    SECTION("Failed rotation keeps measuring the file it left in place") {
+        Metrics::FileSinkOptions options;
+        options.max_bytes = 10;
+
+        Metrics::FileSink sink(path.string(), options);
+        sink.write("aaaa\n");
+        sink.write("bbbb\n");
+
+        // a non-empty directory in the way makes the rename fail
+        const std::filesystem::path blocker = path.string() + ".1";
+        std::filesystem::create_directory(blocker);
+        std::ofstream(blocker / "keep") << "x";
+
+        sink.write("cccc\n");
+        REQUIRE(readFile(path) == "aaaa\nbbbb\ncccc\n");
+
+        sink.write("dddd\n");  // retried under the next index
+        sink.close();
+        REQUIRE(readFile(path.string() + ".2") == "aaaa\nbbbb\ncccc\n");
+        REQUIRE(readFile(path) == "dddd\n");
+    }
+
+    SECTION("Age based rotation happens without further writes") {
+        Metrics::FileSinkOptions options;
+        options.max_age = std::chrono::seconds(1);
+
+        Metrics::FileSink sink(path.string(), options);
+        sink.write("old\n");
+
+        const std::string rotated = path.string() + ".1";
+        for (int i = 0; i < 300 && !std::filesystem::exists(rotated); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        REQUIRE(readFile(rotated) == "old\n");
+        REQUIRE(readFile(path).empty());
+    }
+
+    SECTION("Rotation index continues after restart and old files are pruned"
+    ) {
+        Metrics::FileSinkOptions options;
+        options.max_bytes = 1;
+        options.max_files = 2;
+
+        {
+            Metrics::FileSink sink(path.string(), options);
+            for (const char* record : {"1\n", "2\n", "3\n"}) {
+                sink.write(record);
+            }
+        }
+        {
+            Metrics::FileSink sink(path.string(), options);
+            sink.write("4\n");
+        }
+
+        REQUIRE_FALSE(std::filesystem::exists(path.string() + ".1"));
+        REQUIRE(readFile(path.string() + ".2") == "2\n");
+        REQUIRE(readFile(path.string() + ".3") == "3\n");
+        REQUIRE(readFile(path) == "4\n");
+    }
+
+    SECTION("Group commit settings do not change content") {
+        Metrics::FileSinkOptions options;
+        options.sync_every = 2;
+        options.sync_interval = std::chrono::milliseconds(1);
+
+        Metrics::FileSink sink(path.string(), options);
+        for (int i = 0; i < 5; ++i) sink.write("x\n");
+        sink.sync();
+        sink.close();
+
+        REQUIRE(readFile(path) == "x\nx\nx\nx\nx\n");
+        REQUIRE_FALSE(sink.write("late\n"));
+    }
+
+#ifdef METRICS_CPP_WITH_ZLIB
+    SECTION("Rotated files are compressed in the background") {
+        Metrics::FileSinkOptions options;
+        options.max_bytes = 1;
+        options.compress = true;
+
+        Metrics::FileSink sink(path.string(), options);
+        sink.write("a\n");
+        sink.write("b\n");
+
+        const std::string rotated = path.string() + ".1";
+        for (int i = 0; i < 100 && std::filesystem::exists(rotated); ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        REQUIRE_FALSE(std::filesystem::exists(rotated));
+        REQUIRE(std::filesystem::exists(rotated + ".gz"));
+    }
+#endif
+
+    std::filesystem::remove_all(dir);
+}
\ No newline at end of file
@@ -31,6 +31,14 @@ TEST_CASE("Counter basic functionality", "[counter]") {
         REQUIRE(counter.value() == 0);
     }
 
+    SECTION("Total is not affected by reset") {
+        Metrics::Counter counter(100);
+        counter.reset();
+        counter += 5;
+        REQUIRE(counter.value() == 5);
+        REQUIRE(counter.total() == 105);
+    }
+
     SECTION("Shared counter behavior") {
         Metrics::Counter counter1(25);
         Metrics::Counter counter2 = counter1;  // shared metric
@@ -1,7 +1,11 @@
+#include <atomic>
 #include <catch2/catch_approx.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include <metrics.hpp>
 #include <registry.hpp>
+#include <string>
+#include <thread>
+#include <vector>
 
 TEST_CASE("Registry basic functionality", "[registry]") {
     auto reg =
@@ -51,4 +55,214 @@ TEST_CASE("Registry basic functionality", "[registry]") {
         REQUIRE(metrics.find("metric1") != metrics.end());
         REQUIRE(metrics.find("metric2") != metrics.end());
     }
+
+    SECTION("Collect visits only changed metrics") {
+        auto hot = reg->getMetric<Metrics::Counter>("hot");
+        reg->getMetric<Metrics::Counter>("idle");
+
+        std::vector<std::string> changed;
+        auto record = [&](const std::string& name,
+                          const std::shared_ptr<Metrics::IMetrics>&,
+                          bool is_changed) {
+            if (is_changed) changed.push_back(name);
+        };
+
+        reg->collect(record);  // new metrics start dirty
+        REQUIRE(changed.size() == 2);
+
+        changed.clear();
+        reg->collect(record);
+        REQUIRE(changed.empty());
+
+        hot++;
+        hot += 2;
+        reg->collect(record);
+        REQUIRE(changed == std::vector<std::string> {"hot"});
+    }
+
+    SECTION("Collect with clean metrics") {
+        reg->addMetric("a", std::make_shared<Metrics::Counter>(1));
+        reg->addMetric("b", std::make_shared<Metrics::Gauge>(2.0));
+        reg->collect([](auto&&...) {});
+
+        reg->getMetric<Metrics::Gauge>("b") += 1.0;
+
+        std::size_t visited = 0, changed = 0;
+        reg->collect(
+            [&](const std::string&,
+                const std::shared_ptr<Metrics::IMetrics>&,
+                bool is_changed) {
+                ++visited;
+                changed += is_changed;
+            },
+            true
+        );
+        REQUIRE(visited == 2);
+        REQUIRE(changed == 1);
+    }
+
+    SECTION("Collectors with their own cursors each see every change") {
+        auto hot = reg->getMetric<Metrics::Counter>("hot");
+        reg->getMetric<Metrics::Counter>("idle");
+
+        Metrics::DirtyCursor first, second;
+        auto changed = [&](Metrics::DirtyCursor& cursor) {
+            std::vector<std::string> names;
+            reg->collect(
+                cursor,
+                [&](const std::string& name,
+                    const std::shared_ptr<Metrics::IMetrics>&,
+                    bool is_changed) {
+                    if (is_changed) names.push_back(name);
+                }
+            );
+            return names;
+        };
+
+        REQUIRE(changed(first).size() == 2);  // a new cursor sees everything
+        REQUIRE(changed(first).empty());
+
+        hot += 10;
+        REQUIRE(changed(first) == std::vector<std::string> {"hot"});
+        REQUIRE(changed(second).size() == 2);
+        REQUIRE(changed(second).empty());
+
+        hot++;
+        REQUIRE(changed(second) == std::vector<std::string> {"hot"});
+        REQUIRE(changed(first) == std::vector<std::string> {"hot"});
+
+        // the cursor-less overload has its own, untouched by the others
+        std::size_t reported = 0;
+        reg->collect([&](auto&&...) { ++reported; });
+        REQUIRE(reported == 2);
+    }
+
+    SECTION("Released cursors are reused from scratch") {
+        reg->getMetric<Metrics::Counter>("m");
+        std::size_t reported = 0;
+        auto count = [&](auto&&...) { ++reported; };
+
+        {
+            Metrics::DirtyCursor cursor;
+            reg->collect(cursor, count);
+            reg->collect(cursor, count);
+        }
+        Metrics::DirtyCursor next;
+        reg->collect(next, count);
+        REQUIRE(reported == 2);
+
+        auto other = Metrics::createRegistry();
+        other->getMetric<Metrics::Gauge>("g");
+        other->collect(next, count);
+        REQUIRE(reported == 3);
+    }
+
+    SECTION("Metric shared between registries is always reported") {
+        auto other = Metrics::createRegistry();
+        Metrics::Counter shared {1};
+        reg->addMetric("shared", shared.get_ptr());
+        other->addMetric("shared", shared.get_ptr());
+
+        std::size_t reported = 0;
+        auto count = [&](auto&&...) { ++reported; };
+        other->collect(count);
+        other->collect(count);
+        REQUIRE(reported == 2);
+    }
+
+    SECTION("Remove metric") {
+        reg->addMetric("removable", std::make_shared<Metrics::Counter>(3));
+
+        REQUIRE(reg->removeMetric("removable"));
+        REQUIRE_FALSE(reg->removeMetric("removable"));
+        REQUIRE(reg->getMetricGroup().count("removable") == 0);
+
+        // a later lookup registers a fresh metric under the same name
+        REQUIRE(reg->getMetric<Metrics::Counter>("removable").value() == 0);
+    }
+
+    SECTION("Re-registered metric is tracked again") {
+        Metrics::Counter counter {1};
+        reg->addMetric("cycled", counter.get_ptr());
+        reg->removeMetric("cycled");
+        reg->addMetric("cycled", counter.get_ptr());
+
+        std::size_t reported = 0;
+        auto count = [&](auto&&...) { ++reported; };
+        reg->collect(count);
+        reg->collect(count);
+        REQUIRE(reported == 1);
+
+        counter++;
+        reg->collect(count);
+        REQUIRE(reported == 2);
+    }
+
+    SECTION("getOrCreate reports a type mismatch") {
+        reg->addMetric("typed", std::make_shared<Metrics::Gauge>(1.5));
+
+        auto wrong = reg->getOrCreate<Metrics::Counter>("typed");
+        REQUIRE_FALSE(wrong.has_value());
+        REQUIRE(wrong.error == Metrics::LookupError::TypeMismatch);
+
+        auto gauge = reg->getOrCreate<Metrics::Gauge>("typed");
+        REQUIRE(gauge.has_value());
+        REQUIRE(gauge.error == Metrics::LookupError::None);
+        REQUIRE(gauge->value() == Catch::Approx(1.5));
+
+        // getMetric hands out a detached counter, but counts it
+        REQUIRE(reg->rejected() == 0);
+        reg->getMetric<Metrics::Counter>("typed")++;
+        REQUIRE(reg->rejected() == 1);
+        REQUIRE(reg->getMetric<Metrics::Gauge>("typed").value() == 1.5);
+
+        auto created = reg->getOrCreate<Metrics::Counter>("created");
+        REQUIRE(created.has_value());
+        *created += 4;
+        REQUIRE(reg->getMetric<Metrics::Counter>("created").value() == 4);
+    }
+
+    SECTION("Concurrent registration, removal and collection") {
+        constexpr int kThreads = 4;
+        constexpr int kRounds = 2000;
+
+        std::atomic<bool> done {false};
+        std::atomic<int> broken {0};
+        std::thread collector([&] {
+            while (!done.load()) {
+                reg->collect(
+                    [&](const std::string& name,
+                        const std::shared_ptr<Metrics::IMetrics>& metric,
+                        bool) {
+                        if (name.empty() || !metric) broken++;
+                    },
+                    true
+                );
+            }
+        });
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < kThreads; ++t) {
+            workers.emplace_back([&, t] {
+                for (int i = 0; i < kRounds; ++i) {
+                    const std::string name =
+                        "w" + std::to_string(t) + "_" + std::to_string(i % 16);
+                    reg->getMetric<Metrics::Counter>(name)++;
+                    reg->getMetric<Metrics::Counter>("shared")++;
+                    if (i % 3 == 0) reg->removeMetric(name);
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        done = true;
+        collector.join();
+
+        REQUIRE(broken == 0);
+        REQUIRE(
+            reg->getMetric<Metrics::Counter>("shared").value() ==
+            kThreads * kRounds
+        );
+        auto group = reg->getMetricGroup();
+        REQUIRE(group.size() <= kThreads * 16 + 1);
+    }
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <catch2/catch_approx.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <dumper.hpp>
+#include <filesystem>
+#include <metrics.hpp>
+#include <registry.hpp>
+#include <self_stats.hpp>
+#include <string>
+
+namespace {
+
+// Built before main, so it is destroyed after the statistics' own statics
+// and reports its series from its destructor at exit.
+const std::shared_ptr<Metrics::Registry> g_global = Metrics::getRegistry();
+
+}  // namespace
+
+TEST_CASE("Self statistics", "[self_stats]") {
+    auto self = Metrics::SelfStats::getSelfRegistry();
+
+#ifdef METRICS_CPP_SELF_STATS
+    auto stat = [&](const char* name) {
+        double value = 0;
+        self->collect(
+            [&](const std::string& metric_name,
+                const std::shared_ptr<Metrics::IMetrics>& metric,
+                bool) {
+                if (metric_name != name) return;
+                Metrics::ValueVisitor<Metrics::Counter> counter;
+                Metrics::ValueVisitor<Metrics::Gauge> gauge;
+                metric->accept(counter);
+                metric->accept(gauge);
+                value = counter.matched()
+                            ? static_cast<double>(counter.getResult().value())
+                            : gauge.getResult().value();
+            },
+            true
+        );
+        return value;
+    };
+
+    SECTION("Registry operations are counted") {
+        auto reg = Metrics::createRegistry();
+        const double lookups = stat("metrics.registry.lookups");
+        const double series = stat("metrics.registry.series");
+        const double inserts = stat("metrics.registry.inserts");
+
+        reg->getMetric<Metrics::Counter>("a");
+        reg->getMetric<Metrics::Counter>("a");
+        reg->addMetric("b", std::make_shared<Metrics::Gauge>());
+
+        REQUIRE(stat("metrics.registry.lookups") >= lookups + 2);
+        REQUIRE(stat("metrics.registry.inserts") >= inserts + 2);
+        REQUIRE(stat("metrics.registry.series") == Catch::Approx(series + 2));
+        REQUIRE(stat("metrics.registry.bytes_per_metric") > 0);
+
+        reg->removeMetric("a");
+        REQUIRE(stat("metrics.registry.series") == Catch::Approx(series + 1));
+    }
+
+    SECTION("The global registry is counted") {
+        const double series = stat("metrics.registry.series");
+
+        g_global->getMetric<Metrics::Counter>("self_stats_global")++;
+        REQUIRE(stat("metrics.registry.series") == Catch::Approx(series + 1));
+    }
+
+    SECTION("Destroyed registries give back their series") {
+        const double series = stat("metrics.registry.series");
+        const double bytes = stat("metrics.registry.bytes");
+
+        for (int r = 0; r < 3; ++r) {
+            auto reg = Metrics::createRegistry();
+            for (int i = 0; i < 100; ++i) {
+                reg->getMetric<Metrics::Counter>("m" + std::to_string(i));
+            }
+            reg->removeMetric("m0");
+        }
+
+        REQUIRE(stat("metrics.registry.series") == Catch::Approx(series));
+        REQUIRE(stat("metrics.registry.bytes") == Catch::Approx(bytes));
+    }
+
+    SECTION("Dumper writes are counted") {
+        const std::string filename = "self_stats_test.txt";
+        auto reg = Metrics::createRegistry();
+        auto dumper = std::make_shared<Metrics::Dumper>(filename);
+        reg->getMetric<Metrics::Counter>("dumped") += 1;
+
+        const double writes = stat("metrics.dumper.writes");
+        const double bytes = stat("metrics.dumper.bytes");
+        dumper->write(reg);
+
+        REQUIRE(stat("metrics.dumper.writes") == Catch::Approx(writes + 1));
+        REQUIRE(stat("metrics.dumper.bytes") > bytes);
+
+        dumper->reset();
+        std::filesystem::remove(filename);
+    }
+#else
+    SECTION("Disabled statistics leave the registry empty") {
+        REQUIRE(self->getMetricGroup().empty());
+    }
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,274 @@
+#ifndef _WIN32
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <catch2/catch_test_macros.hpp>
+#include <dumper.hpp>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <metrics.hpp>
+#include <registry.hpp>
+#include <set>
+#include <statsd_exporter.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Local stand-in for a StatsD agent.
+class UdpListener {
+private:
+    int m_fd;
+    uint16_t m_port = 0;
+public:
+    UdpListener() : m_fd(socket(AF_INET, SOCK_DGRAM, 0)) {
+        int rcvbuf = 1 << 22;
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(m_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+
+        socklen_t len = sizeof(addr);
+        getsockname(m_fd, reinterpret_cast<sockaddr*>(&addr), &len);
+        m_port = ntohs(addr.sin_port);
+    }
+
+    ~UdpListener() { close(m_fd); }
+
+    uint16_t port() const { return m_port; }
+
+    // Packets received until none arrive for `timeout_ms`.
+    std::vector<std::string> receive(int timeout_ms = 200) {
+        std::vector<std::string> packets;
+        pollfd pfd {m_fd, POLLIN, 0};
+        char buf[65536];
+        while (poll(&pfd, 1, timeout_ms) > 0) {
+            const ssize_t n = recv(m_fd, buf, sizeof(buf), 0);
+            if (n < 0) break;
+            packets.emplace_back(buf, static_cast<std::size_t>(n));
+        }
+        return packets;
+    }
+};
+
+std::vector<std::string> splitLines(const std::string& packet) {
+    std::vector<std::string> lines;
+    std::size_t start = 0;
+    for (std::size_t end; (end = packet.find('\n', start)) != std::string::npos;
+         start = end + 1) {
+        lines.push_back(packet.substr(start, end - start));
+    }
+    lines.push_back(packet.substr(start));
+    return lines;
+}
+
+}  // namespace
+
+TEST_CASE("StatsD exporter", "[statsd]") {
+    UdpListener listener;
+    auto reg = Metrics::createRegistry();
+
+    SECTION("Lines are packed into packets without being split") {
+        Metrics::StatsdOptions options;
+        options.max_packet = 128;
+        options.batch = 4;  // forces several sendmmsg batches
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", listener.port(), options
+        );
+        REQUIRE(exporter->is_open());
+
+        constexpr int kMetrics = 300;
+        std::set<std::string> expected;
+        for (int i = 0; i < kMetrics; ++i) {
+            const std::string name = "series.number_" + std::to_string(i);
+            reg->getMetric<Metrics::Counter>(name) += i + 1;
+            expected.insert(name + ':' + std::to_string(i + 1) + "|c");
+        }
+
+        exporter->write(reg);
+        auto packets = listener.receive();
+
+        REQUIRE(packets.size() == exporter->packetsSent());
+        REQUIRE(packets.size() > kMetrics / 8);
+
+        std::set<std::string> received;
+        for (const auto& packet : packets) {
+            REQUIRE(packet.size() <= options.max_packet);
+            REQUIRE(packet.back() != '\n');
+            for (const auto& line : splitLines(packet)) received.insert(line);
+        }
+        REQUIRE(received == expected);
+        REQUIRE(exporter->metricsSent() == kMetrics);
+        REQUIRE(exporter->dropped() == 0);
+    }
+
+    SECTION("Counters are sent as deltas, only when changed") {
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", listener.port()
+        );
+        auto requests = reg->getMetric<Metrics::Counter>("requests");
+        auto load = reg->getMetric<Metrics::Gauge>("load");
+        reg->getMetric<Metrics::Counter>("idle");
+
+        requests += 5;
+        load += 0.5;
+        exporter->write(reg);
+        REQUIRE(listener.receive().size() == 1);
+
+        requests += 2;
+        exporter->write(reg);
+        auto packets = listener.receive();
+        REQUIRE(packets == std::vector<std::string> {"requests:2|c"});
+
+        // the exporter leaves the metrics to other sinks
+        REQUIRE(requests.value() == 7);
+        REQUIRE(load.value() == 0.5);
+
+        // a new counter under the same name is sent from zero
+        reg->removeMetric("requests");
+        reg->getMetric<Metrics::Counter>("requests") += 3;
+        exporter->write(reg);
+        REQUIRE(
+            listener.receive() == std::vector<std::string> {"requests:3|c"}
+        );
+    }
+
+    SECTION("Exporter and dumper both report every update") {
+        const std::string filename = "statsd_exporter_test.txt";
+        std::filesystem::remove(filename);
+        auto dumper = std::make_shared<Metrics::Dumper>(
+            filename, Metrics::DumpMode::Sparse
+        );
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", listener.port()
+        );
+        auto hits = reg->getMetric<Metrics::Counter>("hits");
+        auto cpu = reg->getMetric<Metrics::Gauge>("cpu");
+        dumper->write(reg);
+        exporter->write(reg);
+        listener.receive();
+
+        hits += 10;
+        exporter->write(reg);
+        dumper->write(reg);  // resets the counter
+        REQUIRE(listener.receive() == std::vector<std::string> {"hits:10|c"});
+
+        hits += 5;
+        dumper->write(reg);
+        exporter->write(reg);
+        REQUIRE(listener.receive() == std::vector<std::string> {"hits:5|c"});
+
+        cpu += 0.97;
+        dumper->write(reg);  // leaves the gauge alone
+        exporter->write(reg);
+        REQUIRE(listener.receive() == std::vector<std::string> {"cpu:0.97|g"});
+        dumper->reset();
+
+        std::ifstream file(filename);
+        std::string line;
+        std::getline(file, line);
+        std::getline(file, line);
+        REQUIRE(line.find("\"hits\" 10") != std::string::npos);
+        std::getline(file, line);
+        REQUIRE(line.find("\"hits\" 5") != std::string::npos);
+        std::getline(file, line);
+        REQUIRE(line.find("\"cpu\" 0.97") != std::string::npos);
+        file.close();
+        std::filesystem::remove(filename);
+    }
+
+    SECTION("Names are sanitized and prefixed") {
+        Metrics::StatsdOptions options;
+        options.prefix = "app.";
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", listener.port(), options
+        );
+        reg->getMetric<Metrics::Gauge>("HTTP RPS|x") += 1.5;
+
+        exporter->write(reg);
+        REQUIRE(
+            listener.receive() ==
+            std::vector<std::string> {"app.HTTP_RPS_x:1.5|g"}
+        );
+    }
+
+    SECTION("Negative gauges are set, not adjusted") {
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", listener.port()
+        );
+        reg->getMetric<Metrics::Gauge>("temp") -= 3.5;
+
+        exporter->write(reg);
+        REQUIRE(
+            listener.receive() ==
+            std::vector<std::string> {"temp:0|g\ntemp:-3.5|g"}
+        );
+    }
+
+    SECTION("Non-finite gauges are dropped") {
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", listener.port()
+        );
+        reg->getMetric<Metrics::Gauge>("inf") +=
+            std::numeric_limits<double>::infinity();
+        reg->getMetric<Metrics::Gauge>("nan") +=
+            std::numeric_limits<double>::quiet_NaN();
+        reg->getMetric<Metrics::Gauge>("ok") += 1;
+
+        exporter->write(reg);
+        REQUIRE(listener.receive() == std::vector<std::string> {"ok:1|g"});
+        REQUIRE(exporter->dropped() == 2);
+        REQUIRE(exporter->metricsSent() == 1);
+    }
+
+    SECTION("Metrics in refused packets are not counted as sent") {
+        uint16_t closed_port;
+        {
+            UdpListener gone;
+            closed_port = gone.port();
+        }
+
+        Metrics::StatsdOptions options;
+        options.max_packet = 16;  // two "mN:0|c" lines per packet
+        options.mode = Metrics::DumpMode::Full;
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", closed_port, options
+        );
+        for (int i = 0; i < 10; ++i) {
+            reg->getMetric<Metrics::Counter>("m" + std::to_string(i));
+        }
+
+        // the port-unreachable reply makes the kernel refuse later sends
+        for (int i = 0; i < 50 && exporter->dropped() == 0; ++i) {
+            exporter->write(reg);
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        REQUIRE(exporter->dropped() > 0);
+        REQUIRE(exporter->metricsSent() == 2 * exporter->packetsSent());
+    }
+
+    SECTION("Oversized lines are dropped") {
+        Metrics::StatsdOptions options;
+        options.max_packet = 16;
+        auto exporter = std::make_shared<Metrics::StatsdExporter>(
+            "127.0.0.1", listener.port(), options
+        );
+        reg->getMetric<Metrics::Counter>(std::string(64, 'n'))++;
+        reg->getMetric<Metrics::Counter>("ok")++;
+
+        exporter->write(reg);
+        REQUIRE(listener.receive() == std::vector<std::string> {"ok:1|c"});
+        REQUIRE(exporter->dropped() == 1);
+    }
+}
+
+#endif
\ No newline at end of file